@@ -0,0 +1,136 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Replaces every global allocation function to count the allocations.
+// They live in their own translation unit: if the compiler could inline
+// them, it would see `malloc` on one side of a pair and `operator delete`
+// on the other, and warn about mismatched allocation functions.
+
+#include "AllocCounter.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::size_t> allocCount{0};
+
+    void* allocate(std::size_t mSize) noexcept
+    {
+        ++allocCount;
+        return std::malloc(mSize != 0 ? mSize : 1);
+    }
+    void* allocateOrThrow(std::size_t mSize)
+    {
+        if(void* p = allocate(mSize)) return p;
+        throw std::bad_alloc{};
+    }
+    void release(void* mPtr) noexcept { std::free(mPtr); }
+
+#ifdef __cpp_aligned_new
+    // The pointer returned by `malloc` is stored right before the aligned
+    // block, so that `release` stays a plain `free`.
+    void* allocateAligned(std::size_t mSize, std::align_val_t mAlign) noexcept
+    {
+        const auto align(static_cast<std::size_t>(mAlign));
+        void* raw{allocate(mSize + align + sizeof(void*))};
+        if(raw == nullptr) return nullptr;
+
+        const auto start(
+            reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*));
+        auto* result(
+            reinterpret_cast<void**>((start + align - 1) & ~(align - 1)));
+        result[-1] = raw;
+        return result;
+    }
+    void* allocateAlignedOrThrow(std::size_t mSize, std::align_val_t mAlign)
+    {
+        if(void* p = allocateAligned(mSize, mAlign)) return p;
+        throw std::bad_alloc{};
+    }
+    void releaseAligned(void* mPtr) noexcept
+    {
+        if(mPtr != nullptr) std::free(static_cast<void**>(mPtr)[-1]);
+    }
+#endif
+}
+
+namespace bench
+{
+    std::size_t getAllocCount() noexcept { return allocCount.load(); }
+}
+
+void* operator new(std::size_t mSize) { return allocateOrThrow(mSize); }
+void* operator new[](std::size_t mSize) { return allocateOrThrow(mSize); }
+void* operator new(std::size_t mSize, const std::nothrow_t&) noexcept
+{
+    return allocate(mSize);
+}
+void* operator new[](std::size_t mSize, const std::nothrow_t&) noexcept
+{
+    return allocate(mSize);
+}
+
+void operator delete(void* mPtr) noexcept { release(mPtr); }
+void operator delete[](void* mPtr) noexcept { release(mPtr); }
+void operator delete(void* mPtr, std::size_t) noexcept { release(mPtr); }
+void operator delete[](void* mPtr, std::size_t) noexcept { release(mPtr); }
+void operator delete(void* mPtr, const std::nothrow_t&) noexcept
+{
+    release(mPtr);
+}
+void operator delete[](void* mPtr, const std::nothrow_t&) noexcept
+{
+    release(mPtr);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t mSize, std::align_val_t mAlign)
+{
+    return allocateAlignedOrThrow(mSize, mAlign);
+}
+void* operator new[](std::size_t mSize, std::align_val_t mAlign)
+{
+    return allocateAlignedOrThrow(mSize, mAlign);
+}
+void* operator new(std::size_t mSize, std::align_val_t mAlign,
+    const std::nothrow_t&) noexcept
+{
+    return allocateAligned(mSize, mAlign);
+}
+void* operator new[](std::size_t mSize, std::align_val_t mAlign,
+    const std::nothrow_t&) noexcept
+{
+    return allocateAligned(mSize, mAlign);
+}
+
+void operator delete(void* mPtr, std::align_val_t) noexcept
+{
+    releaseAligned(mPtr);
+}
+void operator delete[](void* mPtr, std::align_val_t) noexcept
+{
+    releaseAligned(mPtr);
+}
+void operator delete(void* mPtr, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(mPtr);
+}
+void operator delete[](void* mPtr, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(mPtr);
+}
+void operator delete(
+    void* mPtr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    releaseAligned(mPtr);
+}
+void operator delete[](
+    void* mPtr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    releaseAligned(mPtr);
+}
+#endif
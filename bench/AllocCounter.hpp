@@ -0,0 +1,16 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_BENCH_ALLOCCOUNTER
+#define SSVSC_BENCH_ALLOCCOUNTER
+
+#include <cstddef>
+
+namespace bench
+{
+    // Number of calls to any `operator new` so far.
+    std::size_t getAllocCount() noexcept;
+}
+
+#endif
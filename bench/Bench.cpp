@@ -0,0 +1,580 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Headless benchmark suite for `World::update` and the queries.
+// Every scenario is deterministic (fixed seed, fixed frame time) and the
+// results are printed as a single JSON document on stdout, so that two runs
+// can be diffed or fed to a script.
+//
+// Usage: ssvsc_bench [frames] [threads] [sleep]
+// With `threads` > 0 the worlds use the two-phase update on that many
+// threads (see `World::setThreadCount`). With `sleep` set to 1, resting
+// bodies are put to sleep (see `SleepSettings`).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <SSVSCollision/SSVSCollision.hpp>
+#include "AllocCounter.hpp"
+
+namespace bench
+{
+    using namespace ssvsc;
+
+    using Clock = std::chrono::high_resolution_clock;
+    using GridImpulse = World<Grid, Impulse>;
+    using HashGridRetro = World<HashGrid, Retro>;
+    using SAPImpulse = World<SweepAndPrune, Impulse>;
+    using TreeImpulse = World<DynamicTree, Impulse>;
+    using MultiGridImpulse = World<MultiGrid, Impulse>;
+    using ChunkedGridImpulse = World<ChunkedGrid, Impulse>;
+
+    // Positions are in hundredths of a pixel, like in games built on top of
+    // SSVSCollision: a tile is 16px wide.
+    constexpr int tile{1600}, cellSize{3200}, gridSize{256};
+    constexpr float gravity{25.f};
+    constexpr Group groupSolid{0};
+
+    struct Result
+    {
+        std::string world, scenario;
+        SizeT threads{0}, bodies{0}, frames{0}, pairTests{0}, allocations{0},
+            sleeping{0};
+        double nsTotal{0};
+    };
+
+    struct CellResult
+    {
+        SizeT bodies{0}, ops{0};
+        double nsSwapPop{0}, nsEraseRemove{0};
+    };
+
+    struct QueryResult
+    {
+        std::string world, query;
+        SizeT queries{0}, yielded{0}, allocations{0};
+        double nsTotal{0};
+    };
+
+    struct SnapshotResult
+    {
+        std::string world;
+        SizeT bodies{0}, ops{0}, allocations{0};
+        double nsSave{0}, nsLoad{0};
+    };
+
+    std::vector<Result> results;
+    std::vector<CellResult> cellResults;
+    std::vector<QueryResult> queryResults;
+    std::vector<SnapshotResult> snapshotResults;
+    SizeT threads{0};
+    bool sleep{false};
+
+    // Grids are sized to fit every scenario; other backends need no setup.
+    template <typename TW>
+    struct WorldMaker
+    {
+        inline static auto make()
+        {
+            return std::make_unique<TW>(gridSize, gridSize, cellSize, 8);
+        }
+    };
+    template <template <typename> class TR>
+    struct WorldMaker<World<SweepAndPrune, TR>>
+    {
+        inline static auto make()
+        {
+            return std::make_unique<World<SweepAndPrune, TR>>();
+        }
+    };
+    template <template <typename> class TR>
+    struct WorldMaker<World<DynamicTree, TR>>
+    {
+        inline static auto make()
+        {
+            return std::make_unique<World<DynamicTree, TR>>();
+        }
+    };
+    template <template <typename> class TR>
+    struct WorldMaker<World<ChunkedGrid, TR>>
+    {
+        inline static auto make()
+        {
+            return std::make_unique<World<ChunkedGrid, TR>>(cellSize);
+        }
+    };
+
+    template <typename TW>
+    inline auto& makeBody(TW& mWorld, const Vec2i& mPos, const Vec2i& mSize,
+        bool mStatic, bool mGravity)
+    {
+        auto& b(mWorld.create(mPos, mSize, mStatic));
+        b.addGroups(groupSolid);
+        b.addGroupsToCheck(groupSolid);
+        if(mGravity) b.onPreUpdate += [&b] { b.applyAccel({0.f, gravity}); };
+        return b;
+    }
+
+    template <typename TW>
+    inline void addBorders(TW& mWorld, int mSize)
+    {
+        const int half{mSize / 2};
+        makeBody(mWorld, {half, 0}, {mSize, tile}, true, false);
+        makeBody(mWorld, {half, mSize}, {mSize, tile}, true, false);
+        makeBody(mWorld, {0, half}, {tile, mSize}, true, false);
+        makeBody(mWorld, {mSize, half}, {tile, mSize}, true, false);
+    }
+
+    // Many small dynamic bodies bumping into each other in a closed room.
+    template <typename TW>
+    inline void setupCrowd(TW& mWorld, std::mt19937& mRnd)
+    {
+        constexpr int roomSize{tile * 64};
+        std::uniform_int_distribution<int> pos{tile * 2, roomSize - tile * 2};
+        std::uniform_real_distribution<float> vel{-150.f, 150.f};
+
+        addBorders(mWorld, roomSize);
+        for(int i{0}; i < 2000; ++i)
+        {
+            auto& b(makeBody(mWorld, {pos(mRnd), pos(mRnd)}, {tile, tile},
+                false, false));
+            b.setVelocity({vel(mRnd), vel(mRnd)});
+            b.setRestitutionX(1.f);
+            b.setRestitutionY(1.f);
+        }
+    }
+
+    // Few dynamic bodies spread over a huge area: most cells are empty.
+    template <typename TW>
+    inline void setupSparse(TW& mWorld, std::mt19937& mRnd)
+    {
+        constexpr int fieldSize{cellSize * (gridSize - 8)};
+        std::uniform_int_distribution<int> pos{tile * 2, fieldSize - tile * 2};
+        std::uniform_real_distribution<float> vel{-80.f, 80.f};
+
+        addBorders(mWorld, fieldSize);
+        for(int i{0}; i < 500; ++i)
+        {
+            auto& b(makeBody(mWorld, {pos(mRnd), pos(mRnd)}, {tile, tile},
+                false, false));
+            b.setVelocity({vel(mRnd), vel(mRnd)});
+            b.setRestitutionX(1.f);
+            b.setRestitutionY(1.f);
+        }
+    }
+
+    // A tile map with many static tiles and gravity-affected movers walking
+    // on top of it.
+    template <typename TW>
+    inline void setupPlatformer(TW& mWorld, std::mt19937& mRnd)
+    {
+        constexpr int cols{200}, rows{60};
+        std::uniform_int_distribution<int> platform{0, 99};
+        std::uniform_real_distribution<float> vel{-120.f, 120.f};
+
+        for(int iY{0}; iY < rows; ++iY)
+            for(int iX{0}; iX < cols; ++iX)
+            {
+                const bool border{
+                    iX == 0 || iX == cols - 1 || iY == 0 || iY == rows - 1};
+                const bool ledge{iY % 6 == 5 && platform(mRnd) < 60};
+                if(!border && !ledge) continue;
+
+                makeBody(mWorld, {iX * tile + tile / 2, iY * tile + tile / 2},
+                    {tile, tile}, true, false);
+            }
+
+        for(int i{0}; i < 400; ++i)
+        {
+            const int iX{2 + (i * 7) % (cols - 4)}, iY{2 + (i % 9) * 6};
+            auto& b(makeBody(mWorld, {iX * tile, iY * tile},
+                {tile - 200, tile * 2 - 200}, false, true));
+            b.setVelocity({vel(mRnd), 0.f});
+        }
+    }
+
+    // A large level made of 20k static tiles, with few movers: the cost
+    // should only depend on the movers.
+    template <typename TW>
+    inline void setupTilemap(TW& mWorld, std::mt19937& mRnd)
+    {
+        constexpr int cols{400}, floors{50}, floorHeight{4};
+        std::uniform_real_distribution<float> vel{-120.f, 120.f};
+
+        for(int iF{0}; iF < floors; ++iF)
+            for(int iX{0}; iX < cols; ++iX)
+                makeBody(mWorld,
+                    {iX * tile + tile / 2, (iF + 1) * floorHeight * tile},
+                    {tile, tile}, true, false);
+
+        for(int i{0}; i < 500; ++i)
+        {
+            const int iX{2 + (i * 13) % (cols - 4)}, iF{i % floors};
+            auto& b(makeBody(mWorld,
+                {iX * tile, (iF + 1) * floorHeight * tile - tile * 2},
+                {tile - 200, tile - 200}, false, true));
+            b.setVelocity({vel(mRnd), 0.f});
+        }
+    }
+
+    // Boxes stacked in a pyramid over a static floor, resting on each other.
+    template <typename TW>
+    inline void setupPyramid(TW& mWorld, std::mt19937&)
+    {
+        constexpr int base{40}, floorY{tile * 100};
+        makeBody(mWorld, {tile * 60, floorY}, {tile * 100, tile}, true, false);
+
+        for(int iRow{0}; iRow < base; ++iRow)
+            for(int iX{0}; iX < base - iRow; ++iX)
+            {
+                const int x{tile * 40 + iRow * tile / 2 + iX * tile};
+                const int y{floorY - tile - iRow * tile};
+                makeBody(mWorld, {x, y}, {tile, tile}, false, true);
+            }
+    }
+
+    template <typename TW, typename TSetup>
+    inline void run(const char* mWorldName, const char* mScenario,
+        SizeT mFrames, TSetup mSetup)
+    {
+        auto worldPtr(WorldMaker<TW>::make());
+        auto& world(*worldPtr);
+        world.setThreadCount(threads);
+
+        SleepSettings sleepSettings;
+        sleepSettings.enabled = sleep;
+        world.setSleepSettings(sleepSettings);
+
+        std::mt19937 rnd{1337};
+        mSetup(world, rnd);
+
+        // Warm up: let bodies get their cells and caches reach steady state.
+        for(SizeT i{0}; i < 10; ++i) world.update(1.f);
+
+        Result r;
+        r.world = mWorldName;
+        r.scenario = mScenario;
+        r.threads = threads;
+        r.frames = mFrames;
+
+        for(const auto& b : world.getBodies())
+        {
+            (void)b;
+            ++r.bodies;
+        }
+
+        const auto allocsBefore(getAllocCount());
+        const auto start(Clock::now());
+
+        for(SizeT i{0}; i < mFrames; ++i)
+        {
+            world.update(1.f);
+            r.pairTests += world.getStats().pairTests;
+        }
+
+        r.nsTotal = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        r.allocations = getAllocCount() - allocsBefore;
+        r.sleeping = world.getStats().sleepingBodies;
+        results.emplace_back(r);
+    }
+
+    template <typename TW>
+    inline void runAll(const char* mWorldName, SizeT mFrames)
+    {
+        run<TW>(mWorldName, "crowd", mFrames,
+            [](auto& w, auto& r) { setupCrowd(w, r); });
+        run<TW>(mWorldName, "sparse", mFrames,
+            [](auto& w, auto& r) { setupSparse(w, r); });
+        run<TW>(mWorldName, "platformer", mFrames,
+            [](auto& w, auto& r) { setupPlatformer(w, r); });
+        run<TW>(mWorldName, "pyramid", mFrames,
+            [](auto& w, auto& r) { setupPyramid(w, r); });
+        run<TW>(mWorldName, "tilemap", mFrames,
+            [](auto& w, auto& r) { setupTilemap(w, r); });
+    }
+
+    // Runs `mQueries` queries from random points of the crowd room, after
+    // a first query warmed the scratch buffers up.
+    template <QueryType TType, typename TW, typename... TArgs>
+    inline void runQuery(TW& mWorld, const char* mWorldName,
+        const char* mQuery, SizeT mQueries, const TArgs&... mArgs)
+    {
+        std::mt19937 rnd{1337};
+        std::uniform_int_distribution<int> pos{tile * 2, tile * 62};
+        std::vector<Vec2i> origins(mQueries);
+        for(auto& o : origins) o = Vec2i{pos(rnd), pos(rnd)};
+
+        {
+            auto q(mWorld.template getQuery<TType>(origins[0], mArgs...));
+            while(q.next() != nullptr) {}
+        }
+
+        QueryResult r;
+        r.world = mWorldName;
+        r.query = mQuery;
+        r.queries = mQueries;
+
+        const auto allocsBefore(getAllocCount());
+        const auto start(Clock::now());
+
+        for(const auto& o : origins)
+        {
+            auto q(mWorld.template getQuery<TType>(o, mArgs...));
+            while(q.next() != nullptr) ++r.yielded;
+        }
+
+        r.nsTotal = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        r.allocations = getAllocCount() - allocsBefore;
+        queryResults.emplace_back(r);
+    }
+
+    // Same rays as the `rayCast` run, as a single `World::runQueries`
+    // batch on the bench threads.
+    template <typename TW>
+    inline void runRayBatch(
+        TW& mWorld, const char* mWorldName, SizeT mQueries)
+    {
+        std::mt19937 rnd{1337};
+        std::uniform_int_distribution<int> pos{tile * 2, tile * 62};
+        std::vector<RayRequest> requests(mQueries);
+        for(auto& r : requests)
+            r = RayRequest{Vec2i{pos(rnd), pos(rnd)}, Vec2f{0.6f, 0.8f}};
+
+        std::vector<QueryHit<TW>> hits;
+        mWorld.setThreadCount(threads);
+        mWorld.runQueries(requests, hits);
+
+        QueryResult r;
+        r.world = mWorldName;
+        r.query = "rayCastBatch";
+        r.queries = mQueries;
+
+        const auto allocsBefore(getAllocCount());
+        const auto start(Clock::now());
+
+        mWorld.runQueries(requests, hits);
+
+        r.nsTotal = std::chrono::duration<double, std::nano>(
+            Clock::now() - start).count();
+        r.allocations = getAllocCount() - allocsBefore;
+        for(const auto& h : hits)
+            if(h.body != nullptr) ++r.yielded;
+        queryResults.emplace_back(r);
+    }
+
+    template <typename TW>
+    inline void runQueries(const char* mWorldName, SizeT mQueries)
+    {
+        auto world(WorldMaker<TW>::make());
+        std::mt19937 rnd{1337};
+        setupCrowd(*world, rnd);
+        world->update(1.f);
+
+        runQuery<QueryType::Point>(*world, mWorldName, "point", mQueries);
+        runQuery<QueryType::Distance>(
+            *world, mWorldName, "distance", mQueries, tile * 4);
+        runQuery<QueryType::Nearest>(
+            *world, mWorldName, "nearest", mQueries, SizeT(8));
+        runQuery<QueryType::OrthoDown>(
+            *world, mWorldName, "orthoDown", mQueries);
+        runQuery<QueryType::RayCast>(
+            *world, mWorldName, "rayCast", mQueries, Vec2f{0.6f, 0.8f});
+        runRayBatch(*world, mWorldName, mQueries);
+    }
+
+    // Removes and re-adds random bodies of a single cell, with the O(1)
+    // swap-and-pop of `Cell` and with a linear `eraseRemove` for comparison.
+    inline void runCell(SizeT mBodies, SizeT mOps)
+    {
+        using BodyType = Body<GridImpulse>;
+
+        GridImpulse world{4, 4, cellSize, 0};
+        std::vector<BodyType*> bodies;
+        for(SizeT i{0}; i < mBodies; ++i)
+            bodies.emplace_back(
+                &world.create({tile, tile}, {tile, tile}, false));
+
+        std::mt19937 rnd{1337};
+        std::uniform_int_distribution<SizeT> pick{0, mBodies - 1};
+        std::vector<SizeT> picks(mOps);
+        for(auto& p : picks) p = pick(rnd);
+
+        Cell<GridImpulse> cell;
+        std::vector<Impl::CellIdx> idxs(mBodies);
+        for(SizeT i{0}; i < mBodies; ++i)
+            cell.add(bodies[i], idxs[i], BodyTag{});
+
+        const auto start(Clock::now());
+        for(const auto& p : picks)
+        {
+            cell.del(idxs[p], BodyTag{});
+            cell.add(bodies[p], idxs[p], BodyTag{});
+        }
+        const auto mid(Clock::now());
+
+        std::vector<BodyType*> linear(bodies);
+        for(const auto& p : picks)
+        {
+            ssvu::eraseRemove(linear, bodies[p]);
+            linear.emplace_back(bodies[p]);
+        }
+        const auto end(Clock::now());
+
+        CellResult r;
+        r.bodies = mBodies;
+        r.ops = mOps;
+        r.nsSwapPop =
+            std::chrono::duration<double, std::nano>(mid - start).count() /
+            double(mOps);
+        r.nsEraseRemove =
+            std::chrono::duration<double, std::nano>(end - mid).count() /
+            double(mOps);
+        cellResults.emplace_back(r);
+    }
+
+    // Saves the state of a crowd of `mBodies` bodies, simulates a frame and
+    // rolls it back, `mOps` times. Only saving and loading are timed.
+    template <typename TW>
+    inline void runSnapshot(const char* mWorldName, SizeT mBodies, SizeT mOps)
+    {
+        constexpr int roomSize{tile * 256};
+        std::mt19937 rnd{1337};
+        std::uniform_int_distribution<int> pos{tile * 2, roomSize - tile * 2};
+        std::uniform_real_distribution<float> vel{-150.f, 150.f};
+
+        auto worldPtr(WorldMaker<TW>::make());
+        auto& world(*worldPtr);
+        addBorders(world, roomSize);
+        for(SizeT i{0}; i < mBodies; ++i)
+        {
+            auto& b(makeBody(world, {pos(rnd), pos(rnd)}, {tile, tile},
+                false, false));
+            b.setVelocity({vel(rnd), vel(rnd)});
+        }
+        for(SizeT i{0}; i < 10; ++i) world.update(1.f);
+
+        typename TW::StateType state;
+        world.saveState(state);
+
+        SnapshotResult r;
+        r.world = mWorldName;
+        r.bodies = mBodies;
+        r.ops = mOps;
+
+        for(SizeT i{0}; i < mOps; ++i)
+        {
+            const auto allocsBefore(getAllocCount());
+            const auto start(Clock::now());
+            world.saveState(state);
+            const auto saved(Clock::now());
+            r.allocations += getAllocCount() - allocsBefore;
+
+            world.update(1.f);
+
+            const auto allocsMid(getAllocCount());
+            const auto mid(Clock::now());
+            world.loadState(state);
+            const auto end(Clock::now());
+            r.allocations += getAllocCount() - allocsMid;
+
+            r.nsSave +=
+                std::chrono::duration<double, std::nano>(saved - start)
+                    .count();
+            r.nsLoad +=
+                std::chrono::duration<double, std::nano>(end - mid).count();
+        }
+
+        snapshotResults.emplace_back(r);
+    }
+
+    inline void printJson()
+    {
+        std::printf("{\n    \"results\": [\n");
+        for(SizeT i{0}; i < results.size(); ++i)
+        {
+            const auto& r(results[i]);
+            const double bodyFrames(double(r.bodies) * double(r.frames));
+
+            std::printf(
+                "        {\"world\": \"%s\", \"scenario\": \"%s\", "
+                "\"threads\": %zu, \"bodies\": %zu, \"frames\": %zu, "
+                "\"nsPerBodyFrame\": %.2f, \"pairTests\": %zu, "
+                "\"pairTestsPerFrame\": %.1f, \"allocations\": %zu, "
+                "\"allocationsPerFrame\": %.2f, \"sleeping\": %zu}%s\n",
+                r.world.c_str(), r.scenario.c_str(), r.threads, r.bodies,
+                r.frames,
+                r.nsTotal / bodyFrames, r.pairTests,
+                double(r.pairTests) / double(r.frames), r.allocations,
+                double(r.allocations) / double(r.frames), r.sleeping,
+                i + 1 < results.size() ? "," : "");
+        }
+        std::printf("    ],\n    \"cells\": [\n");
+        for(SizeT i{0}; i < cellResults.size(); ++i)
+        {
+            const auto& r(cellResults[i]);
+            std::printf(
+                "        {\"bodiesPerCell\": %zu, \"ops\": %zu, "
+                "\"nsSwapPop\": %.2f, \"nsEraseRemove\": %.2f}%s\n",
+                r.bodies, r.ops, r.nsSwapPop, r.nsEraseRemove,
+                i + 1 < cellResults.size() ? "," : "");
+        }
+        std::printf("    ],\n    \"queries\": [\n");
+        for(SizeT i{0}; i < queryResults.size(); ++i)
+        {
+            const auto& r(queryResults[i]);
+            std::printf(
+                "        {\"world\": \"%s\", \"query\": \"%s\", "
+                "\"queries\": %zu, \"nsPerQuery\": %.2f, "
+                "\"yieldedPerQuery\": %.2f, "
+                "\"allocationsPerQuery\": %.2f}%s\n",
+                r.world.c_str(), r.query.c_str(), r.queries,
+                r.nsTotal / double(r.queries),
+                double(r.yielded) / double(r.queries),
+                double(r.allocations) / double(r.queries),
+                i + 1 < queryResults.size() ? "," : "");
+        }
+        std::printf("    ],\n    \"snapshots\": [\n");
+        for(SizeT i{0}; i < snapshotResults.size(); ++i)
+        {
+            const auto& r(snapshotResults[i]);
+            std::printf(
+                "        {\"world\": \"%s\", \"bodies\": %zu, "
+                "\"ops\": %zu, \"nsSave\": %.0f, \"nsLoad\": %.0f, "
+                "\"allocationsPerOp\": %.2f}%s\n",
+                r.world.c_str(), r.bodies, r.ops,
+                r.nsSave / double(r.ops), r.nsLoad / double(r.ops),
+                double(r.allocations) / double(r.ops),
+                i + 1 < snapshotResults.size() ? "," : "");
+        }
+        std::printf("    ]\n}\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t frames(
+        argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300);
+    bench::threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    bench::sleep = argc > 3 && std::strtoul(argv[3], nullptr, 10) != 0;
+
+    bench::runAll<bench::GridImpulse>("Grid/Impulse", frames);
+    bench::runAll<bench::HashGridRetro>("HashGrid/Retro", frames);
+    bench::runAll<bench::SAPImpulse>("SweepAndPrune/Impulse", frames);
+    bench::runAll<bench::TreeImpulse>("DynamicTree/Impulse", frames);
+    bench::runAll<bench::MultiGridImpulse>("MultiGrid/Impulse", frames);
+    bench::runAll<bench::ChunkedGridImpulse>("ChunkedGrid/Impulse", frames);
+    for(const auto& n : {10, 100, 1000}) bench::runCell(n, 100000);
+    bench::runQueries<bench::GridImpulse>("Grid/Impulse", 10000);
+    bench::runQueries<bench::TreeImpulse>("DynamicTree/Impulse", 10000);
+    bench::runSnapshot<bench::GridImpulse>("Grid/Impulse", 10000, 100);
+    bench::runSnapshot<bench::SAPImpulse>("SweepAndPrune/Impulse", 10000, 100);
+    bench::runSnapshot<bench::TreeImpulse>("DynamicTree/Impulse", 10000, 100);
+    bench::printJson();
+
+    return 0;
+}
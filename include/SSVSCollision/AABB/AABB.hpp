@@ -13,6 +13,7 @@ namespace ssvsc
         Vec2i position, halfSize;
 
     public:
+        inline AABB() noexcept = default;
         inline AABB(const Vec2i& mPosition, const Vec2i& mHalfSize) noexcept
             : position{mPosition},
               halfSize{mHalfSize}
@@ -148,6 +149,12 @@ namespace ssvsc
             return !isLeftOf(mX) && !isRightOf(mX) && !isAbove(mX) &&
                    !isBelow(mX);
         }
+        // Like `isOverlapping`, but also true for boxes sharing an edge.
+        inline bool isTouching(const AABB& mX) const noexcept
+        {
+            return getRight() >= mX.getLeft() && getLeft() <= mX.getRight() &&
+                   getBottom() >= mX.getTop() && getTop() <= mX.getBottom();
+        }
         inline bool contains(const Vec2i& mX) const noexcept
         {
             return isOverlapping(mX);
@@ -12,8 +12,10 @@ namespace ssvsc
     class Body;
 
     template <typename TW>
-    class Base : public Groupable
+    class Base : public GroupableOf<Base<TW>, TW::groupCount>
     {
+        friend GroupableOf<Base<TW>, TW::groupCount>;
+
     public:
         using SpatialInfoType = typename TW::SpatialInfoType;
         using DetectionInfoType = typename TW::DetectionInfoType;
@@ -31,9 +33,12 @@ namespace ssvsc
         {
         }
 
-    public:
-        using Groupable::Groupable;
+        inline void onGroupsChanged() noexcept
+        {
+            spatialInfo.refreshGroups();
+        }
 
+    public:
         inline Base() = default;
 
         inline Base(const Base&) = delete;
@@ -49,13 +54,17 @@ namespace ssvsc
 
         inline auto& getWorld() const noexcept { return world; }
         inline auto& getSpatialInfo() noexcept { return spatialInfo; }
+        inline const auto& getSpatialInfo() const noexcept
+        {
+            return spatialInfo;
+        }
         inline bool mustCheck(const Base& mX) const noexcept
         {
-            return mX.hasAnyGroup(getGroupsToCheck());
+            return mX.hasAnyGroup(this->getGroupsToCheck());
         }
         inline bool mustIgnoreResolution(const Base& mX) const noexcept
         {
-            return mX.hasAnyGroup(getGroupsNoResolve());
+            return mX.hasAnyGroup(this->getGroupsNoResolve());
         }
     };
 }
@@ -7,8 +7,12 @@
 
 #include "SSVSCollision/Body/CallbackInfo.hpp"
 #include "SSVSCollision/Body/BodyData.hpp"
+#include "SSVSCollision/Body/BodyStorage.hpp"
 #include "SSVSCollision/Body/Groupable.hpp"
 #include "SSVSCollision/Body/Base.hpp"
+#include "SSVSCollision/World/DetectionBuffer.hpp"
+#include "SSVSCollision/World/ContactCache.hpp"
+#include "SSVSCollision/World/EventBuffer.hpp"
 
 namespace ssvsc
 {
@@ -28,20 +32,34 @@ namespace ssvsc
         friend ResolverInfoType;
 
     protected:
+        // Hot state lives in the world's `BodyStorage`, `data` only holds
+        // what integration and detection never touch.
         BodyData data;
+        SizeT slot;
+        Impl::BodyStorage::Chunk* chunk;
+        SizeT idx;
         std::vector<Body*> toResolve;
         void* userData{nullptr};
         bool mustInit{true};
 
-        inline void integrate(FT mFT) noexcept
-        {
-            data.velocity += getAcceleration() * mFT;
-            getShape().move(Vec2i(getVelocity() * mFT));
-            ssvs::nullify(data.acceleration);
-        }
+        // Sleeping state, see `SleepSettings`. `islandNext` links the
+        // bodies that fell asleep together in a ring.
+        SizeT restingFrames{0}, islandIdx{0};
+        Body* islandNext{nullptr};
 
-        inline void update(FT mFT)
+        // Runs the per-frame callbacks and saves the old state. Returns
+        // `false` if the body does not have to move nor detect collisions
+        // this frame.
+        inline bool prepare()
         {
+            toResolve.clear();
+
+            if(this->world.savingPositions)
+            {
+                chunk->prevPositions[idx] = getPosition();
+                chunk->prevSteps[idx] = this->world.positionsStep;
+            }
+
             if(mustInit)
             {
                 this->spatialInfo.template init<BodyTag>();
@@ -52,42 +70,306 @@ namespace ssvsc
 
             this->onPreUpdate();
 
+            // Made static this frame: the dynamic layer is only rebuilt
+            // by the next one.
             if(isStatic())
             {
                 this->spatialInfo.template preUpdate<BodyTag>();
-                return;
+                return false;
             }
             if(this->outOfBounds)
             {
                 onOutOfBounds();
                 this->outOfBounds = false;
+                return false;
+            }
+            chunk->oldShapes[idx] = getShape();
+            chunk->oldVelocities[idx] = getVelocity();
+            return true;
+        }
+
+        // Statics are not updated every frame: the world refreshes them
+        // only when the static layer changes.
+        inline void refreshStatic()
+        {
+            if(!mustInit)
+            {
+                this->spatialInfo.template preUpdate<BodyTag>();
                 return;
             }
-            data.oldShape = getShape();
-            data.oldVelocity = getVelocity();
-            integrate(mFT);
-            this->spatialInfo.template preUpdate<BodyTag>();
 
+            this->spatialInfo.template init<BodyTag>();
+            mustInit = false;
+        }
+        // A moved or resized static invalidates the static layer, and wakes
+        // the bodies around its old and new shapes.
+        inline void invalidate()
+        {
+            wake();
+            this->spatialInfo.invalidate();
+            if(!isStatic()) return;
+
+            this->world.invalidateLayers();
+            this->world.addWakeArea(getOldShape());
+            this->world.addWakeArea(getShape());
+        }
+
+        inline void updateResting() noexcept
+        {
+            const auto& s(this->world.sleep);
+            const auto& v(getVelocity());
+            const auto& r(data.lastResolution);
+
+            const bool resting{std::abs(v.x) <= s.maxVelocity &&
+                               std::abs(v.y) <= s.maxVelocity &&
+                               std::abs(r.x) <= s.maxResolution &&
+                               std::abs(r.y) <= s.maxResolution};
+
+            restingFrames = resting ? restingFrames + 1 : 0;
+        }
+        inline void sleep(Body* mIslandNext) noexcept
+        {
+            chunk->flags[idx] |= Impl::BodyFlags::asleep;
+            ssvs::nullify(chunk->velocities[idx]);
             toResolve.clear();
-            this->spatialInfo.template handleCollisions<BodyTag>(mFT);
+            islandNext = mIslandNext;
+        }
 
+        inline void resolve()
+        {
             this->world.resolver.resolve(*this, toResolve);
             if(getOldShape() != getShape()) this->spatialInfo.invalidate();
+            if(this->world.sleep.enabled) updateResting();
 
             this->spatialInfo.postUpdate();
             onPostUpdate();
         }
 
-        inline void handleCollision(FT mFT, Body* mBody)
+        inline bool mustSweep() const noexcept
+        {
+            const auto& v(getVelocity());
+            return isContinuous() ||
+                   std::max(std::abs(v.x), std::abs(v.y)) >
+                       this->world.continuousSpeed;
+        }
+
+        // Continuous collision detection: moves the shape back along its
+        // path to the earliest time of impact against the bodies it
+        // resolves against, one unit inside them, so that detection and
+        // resolution see the contact instead of the body tunneling
+        // through. Only the axis of the impact is clamped, so bodies can
+        // still slide; each axis is clamped at most once.
+        // A body that does not resolve is stopped at the first body it
+        // checks instead, on both axes: the hit is detected this frame,
+        // and the body moves on through it from the next one.
+        inline void sweep()
+        {
+            const auto& old(getOldShape());
+            Vec2i delta{getPosition() - old.getPosition()};
+            bool clamped[2]{false, false};
+            const bool resolves{getResolve()};
+
+            for(int iPass{0}; iPass < 2 && delta != Vec2i{0, 0}; ++iPass)
+            {
+                AABB moved{old};
+                moved.move(delta);
+
+                // Grown by one unit: boxes sharing an edge are hit too.
+                const AABB area{
+                    std::min(old.getLeft(), moved.getLeft()) - 1,
+                    std::max(old.getRight(), moved.getRight()) + 1,
+                    std::min(old.getTop(), moved.getTop()) - 1,
+                    std::max(old.getBottom(), moved.getBottom()) + 1};
+
+                float best{2.f};
+                SizeT bestAxis{0};
+
+                auto q(this->world.template getQuery<QueryType::Area>(area));
+                while(Body* b = q.next())
+                {
+                    if(b == this || !this->mustCheck(*b) ||
+                        (resolves && !mustResolveAgainst(*b)))
+                        continue;
+
+                    float t;
+                    SizeT axis;
+                    if(Utils::isSweepHitting(
+                           old, Vec2f(delta), b->getShape(), t, axis) &&
+                        !clamped[axis] && t < best)
+                    {
+                        best = t;
+                        bestAxis = axis;
+                    }
+                }
+
+                if(best > 1.f) break;
+
+                if(!resolves)
+                {
+                    auto& d(bestAxis == 0 ? delta.x : delta.y);
+                    const int sign{d < 0 ? -1 : 1};
+                    const Vec2f stop(Vec2f(delta) * best);
+
+                    delta = Vec2i{
+                        int(std::round(stop.x)), int(std::round(stop.y))};
+                    d += sign;
+                    break;
+                }
+
+                auto& d(bestAxis == 0 ? delta.x : delta.y);
+                const int sign{d < 0 ? -1 : 1};
+                const int clampedD{
+                    int(std::round(float(d) * best)) + sign};
+
+                if(std::abs(clampedD) < std::abs(d)) d = clampedD;
+                clamped[bestAxis] = true;
+            }
+
+            getShape().setPosition(old.getPosition() + delta);
+            // Cells are only recomputed from the moved shape when the
+            // body moved last frame too: a bullet fired this frame would
+            // miss what stopped it.
+            this->spatialInfo.invalidate();
+        }
+
+        // Serial update of a moved body: every body of the frame was
+        // prepared and moved before, so that the pairs are dispatched
+        // once, with the shapes the two-phase update sees.
+        inline void update(FT mFT)
         {
-            if(mBody == this || !this->mustCheck(*mBody) ||
-                !getShape().isOverlapping(mBody->getShape()))
+            this->spatialInfo.template handleCollisions<BodyTag>(mFT);
+
+            resolve();
+        }
+
+        inline bool isDetecting() const noexcept
+        {
+            return chunk->flags[idx] & Impl::BodyFlags::detecting;
+        }
+
+        // Detection phase of the two-phase update: only reads the shared
+        // state, so it can run on any thread. Overlaps are written to
+        // `mBuffer` and dispatched later by `dispatchContacts`.
+        // A pair of detecting bodies is tested by the lower slot only.
+        inline void detect(Impl::DetectionBuffer<TW>& mBuffer, SizeT mThread)
+        {
+            this->spatialInfo.template forEachCandidate<BodyTag>(
+                mThread, [this, &mBuffer](Body* mBody)
+                {
+                    if(mBody == this) return;
+
+                    const bool otherDetecting{mBody->isDetecting()};
+                    if(otherDetecting && mBody->slot < slot) return;
+
+                    const bool checks{this->mustCheck(*mBody)};
+                    const bool otherChecks{
+                        otherDetecting && mBody->mustCheck(*this)};
+                    if(!checks && !otherChecks) return;
+
+                    ++mBuffer.pairTests;
+                    if(!getShape().isOverlapping(mBody->getShape())) return;
+
+                    mBuffer.contacts.push_back({mBody,
+                        checks && mustResolveAgainst(*mBody),
+                        otherChecks && mBody->mustResolveAgainst(*this)});
+                });
+        }
+
+        // Fires the callbacks of both sides once, and fills the resolution
+        // lists of both sides. Bodies resolve once all contacts are
+        // dispatched.
+        inline void dispatchContacts(FT mFT, const Impl::Contact<TW>* mBegin,
+            const Impl::Contact<TW>* mEnd)
+        {
+            for(; mBegin != mEnd; ++mBegin)
+            {
+                Body* other{mBegin->other};
+                other->wake();
+                notifyDetection(mFT, *other);
+
+                touchContact(mFT, *other);
+
+                if(mBegin->resolve) toResolve.emplace_back(other);
+                if(mBegin->resolveOther) other->toResolve.emplace_back(this);
+            }
+        }
+
+        // Calls `onDetection` on both sides, or records the event, see
+        // `EventMode`.
+        inline void notifyDetection(FT mFT, Body& mBody)
+        {
+            if(this->world.eventMode == EventMode::Deferred)
+            {
+                this->world.events.detections.push_back({this, &mBody, mFT});
                 return;
+            }
 
-            this->onDetection({*mBody, mBody->getUserData(), mFT});
-            mBody->onDetection({*this, userData, mFT});
+            this->onDetection({mBody, mBody.getUserData(), mFT});
+            mBody.onDetection({*this, userData, mFT});
+        }
 
-            if(mustResolveAgainst(*mBody)) toResolve.emplace_back(mBody);
+        // Calls `onResolution`, which may veto parts of the resolution, or
+        // records the event, see `EventMode`.
+        inline void notifyResolution(Body& mBody, const Vec2i& mResolution,
+            bool& mNoResolvePosition, bool& mNoResolveVelocity)
+        {
+            if(this->world.eventMode == EventMode::Deferred)
+            {
+                this->world.events.resolutions.push_back(
+                    {this, &mBody, mResolution});
+                return;
+            }
+
+            onResolution({mBody, mBody.getUserData(), mResolution,
+                mNoResolvePosition, mNoResolveVelocity});
+        }
+
+        // Fires `onContactBegin` or `onContactStay` on both sides, once
+        // per pair and frame, when contact events are enabled.
+        inline void touchContact(FT mFT, Body& mBody)
+        {
+            if(!this->world.contactEvents) return;
+
+            switch(this->world.contactCache.touch(*this, mBody))
+            {
+                case Impl::ContactState::Begin:
+                    onContactBegin({mBody, mBody.getUserData(), mFT});
+                    mBody.onContactBegin({*this, userData, mFT});
+                    break;
+                case Impl::ContactState::Stay:
+                    onContactStay({mBody, mBody.getUserData(), mFT});
+                    mBody.onContactStay({*this, userData, mFT});
+                    break;
+                case Impl::ContactState::Seen: break;
+            }
+        }
+
+        // Like `detect`, the lower slot of two detecting bodies dispatches
+        // their pair. The other one only tests it if it resolves against
+        // it: resolution still happens in turn, with the shapes of then.
+        inline void handleCollision(FT mFT, Body* mBody)
+        {
+            if(mBody == this) return;
+
+            const bool otherDetecting{mBody->isDetecting()};
+            const bool dispatches{!otherDetecting || slot < mBody->slot};
+            const bool checks{this->mustCheck(*mBody)};
+            const bool resolves{checks && mustResolveAgainst(*mBody)};
+            const bool otherChecks{
+                otherDetecting && mBody->mustCheck(*this)};
+            if(dispatches ? !checks && !otherChecks : !resolves) return;
+
+            ++this->world.stats.pairTests;
+            if(!getShape().isOverlapping(mBody->getShape())) return;
+
+            if(resolves) toResolve.emplace_back(mBody);
+            if(!dispatches) return;
+
+            ++this->world.stats.contacts;
+            mBody->wake();
+
+            notifyDetection(mFT, *mBody);
+            touchContact(mFT, *mBody);
         }
 
     public:
@@ -96,85 +378,141 @@ namespace ssvsc
         ssvu::Delegate<void()> onPostUpdate, onOutOfBounds;
         ssvu::Delegate<void(const ResolutionInfoType&)> onResolution;
 
+        // Contact events, see `World::setContactEvents`. Unlike
+        // `onDetection`, they fire once per pair and frame.
+        ssvu::Delegate<void(const DetectionInfoType&)> onContactBegin,
+            onContactStay, onContactEnd;
+
         inline Body(TW& mWorld, bool mIsStatic, const Vec2i& mPos,
-            const Vec2i& mSize) noexcept : Base<TW>{mWorld},
-                                           data{mIsStatic, mPos, mSize}
+            const Vec2i& mSize) noexcept
+            : Base<TW>{mWorld},
+              slot{mWorld.storage.acquire(mIsStatic, mPos, mSize)},
+              chunk{&mWorld.storage.getChunk(slot)},
+              idx{Impl::BodyStorage::getIdx(slot)}
         {
         }
-        inline ~Body() noexcept { destroy(); }
+        inline ~Body() noexcept
+        {
+            destroy();
+            this->world.storage.release(slot);
+        }
         inline void destroy()
         {
+            this->world.storage.kill(slot);
+            wake();
+            this->world.addWakeArea(getShape());
+
             this->spatialInfo.template destroy<BodyTag>();
             this->world.delBody(this);
         }
 
+        // Wakes this body and every body of its island.
+        inline void wake() noexcept
+        {
+            if(!isAsleep()) return;
+
+            Body* b{this};
+            do
+            {
+                Body* next{b->islandNext};
+                b->chunk->flags[b->idx] &= ~Impl::BodyFlags::asleep;
+                b->restingFrames = 0;
+                b->islandNext = nullptr;
+                b = next;
+            } while(b != this);
+        }
+
         inline void applyAccel(const Vec2f& mAccel) noexcept
         {
-            data.acceleration += mAccel;
+            wake();
+            chunk->accelerations[idx] += mAccel;
         }
         inline void resolvePosition(const Vec2i& mOffset) noexcept
         {
-            data.shape.move(mOffset);
+            chunk->shapes[idx].move(mOffset);
             data.lastResolution += mOffset;
         }
 
         inline void setPosition(const Vec2i& mPos)
         {
-            data.oldShape = getShape();
-            data.shape.setPosition(mPos);
-            this->spatialInfo.invalidate();
+            chunk->oldShapes[idx] = getShape();
+            chunk->shapes[idx].setPosition(mPos);
+            invalidate();
         }
         inline void setX(int mX)
         {
-            data.oldShape = getShape();
-            data.shape.setX(mX);
-            this->spatialInfo.invalidate();
+            chunk->oldShapes[idx] = getShape();
+            chunk->shapes[idx].setX(mX);
+            invalidate();
         }
         inline void setY(int mY)
         {
-            data.oldShape = getShape();
-            data.shape.setY(mY);
-            this->spatialInfo.invalidate();
+            chunk->oldShapes[idx] = getShape();
+            chunk->shapes[idx].setY(mY);
+            invalidate();
         }
         inline void setSize(const Vec2i& mSize)
         {
-            data.shape.setSize(mSize);
-            this->spatialInfo.invalidate();
+            chunk->shapes[idx].setSize(mSize);
+            invalidate();
         }
         inline void setHalfSize(const Vec2i& mSize)
         {
-            data.shape.setHalfSize(mSize);
-            this->spatialInfo.invalidate();
+            chunk->shapes[idx].setHalfSize(mSize);
+            invalidate();
         }
         inline void setWidth(int mWidth)
         {
-            data.shape.setWidth(mWidth);
-            this->spatialInfo.invalidate();
+            chunk->shapes[idx].setWidth(mWidth);
+            invalidate();
         }
         inline void setHeight(int mHeight)
         {
-            data.shape.setHeight(mHeight);
-            this->spatialInfo.invalidate();
+            chunk->shapes[idx].setHeight(mHeight);
+            invalidate();
         }
         inline void setStatic(bool mStatic)
         {
-            data._static = mStatic;
+            wake();
+            auto& flags(chunk->flags[idx]);
+            flags = mStatic ? (flags | Impl::BodyFlags::isStatic)
+                            : (flags & ~Impl::BodyFlags::isStatic);
             this->spatialInfo.invalidate();
+            this->world.invalidateLayers();
         }
         inline void setVelocity(const Vec2f& mVel) noexcept
         {
-            data.velocity = mVel;
+            wake();
+            chunk->velocities[idx] = mVel;
         }
         inline void setAcceleration(const Vec2f& mAccel) noexcept
         {
-            data.acceleration = mAccel;
+            wake();
+            chunk->accelerations[idx] = mAccel;
         }
         inline void setUserData(void* mUserData) noexcept
         {
             userData = mUserData;
         }
-        inline void setVelocityX(float mX) noexcept { data.velocity.x = mX; }
-        inline void setVelocityY(float mY) noexcept { data.velocity.y = mY; }
+        inline void setVelocityX(float mX) noexcept
+        {
+            wake();
+            chunk->velocities[idx].x = mX;
+        }
+        inline void setVelocityY(float mY) noexcept
+        {
+            wake();
+            chunk->velocities[idx].y = mY;
+        }
+        // Continuous bodies are swept every frame, whatever their speed.
+        // See `World::setContinuousSpeed` for the others, and `sweep` for
+        // what stops them.
+        inline void setContinuous(bool mContinuous) noexcept
+        {
+            auto& flags(chunk->flags[idx]);
+            flags = mContinuous ? (flags | Impl::BodyFlags::continuous)
+                                : (flags & ~Impl::BodyFlags::continuous);
+        }
         inline void setResolve(bool mResolve) noexcept
         {
             data.resolve = mResolve;
@@ -189,12 +527,15 @@ namespace ssvsc
             data.restitution.y = mY;
         }
 
-        inline AABB& getShape() noexcept { return data.shape; }
-        inline AABB& getOldShape() noexcept { return data.oldShape; }
-        inline const AABB& getShape() const noexcept { return data.shape; }
+        inline AABB& getShape() noexcept { return chunk->shapes[idx]; }
+        inline AABB& getOldShape() noexcept { return chunk->oldShapes[idx]; }
+        inline const AABB& getShape() const noexcept
+        {
+            return chunk->shapes[idx];
+        }
         inline const AABB& getOldShape() const noexcept
         {
-            return data.oldShape;
+            return chunk->oldShapes[idx];
         }
         inline const auto& getPosition() const noexcept
         {
@@ -202,19 +543,35 @@ namespace ssvsc
         }
         inline const auto& getVelocity() const noexcept
         {
-            return data.velocity;
+            return chunk->velocities[idx];
         }
         inline const auto& getOldPosition() const noexcept
         {
             return getOldShape().getPosition();
         }
+        // Position before the last substep of `World::advance`. Bodies
+        // that substep did not update (statics, sleeping bodies) are not
+        // interpolated: their current position is returned.
+        inline Vec2i getPrevPosition() const noexcept
+        {
+            return chunk->prevSteps[idx] == this->world.positionsStep
+                       ? chunk->prevPositions[idx]
+                       : getPosition();
+        }
+        // Position between the previous and the current one, weighted by
+        // `mAlpha`: pass `AdvanceResult::alpha` to render between steps.
+        inline Vec2f getInterpolatedPosition(float mAlpha) const noexcept
+        {
+            const Vec2f prev(getPrevPosition());
+            return prev + (Vec2f(getPosition()) - prev) * mAlpha;
+        }
         inline const auto& getOldVelocity() const noexcept
         {
-            return data.oldVelocity;
+            return chunk->oldVelocities[idx];
         }
         inline const auto& getAcceleration() const noexcept
         {
-            return data.acceleration;
+            return chunk->accelerations[idx];
         }
         inline auto getSize() const noexcept { return getShape().getSize(); }
         inline auto getMass() const noexcept
@@ -227,7 +584,23 @@ namespace ssvsc
         }
         inline int getWidth() const noexcept { return getShape().getWidth(); }
         inline int getHeight() const noexcept { return getShape().getHeight(); }
-        inline bool isStatic() const noexcept { return data._static; }
+        inline bool isStatic() const noexcept
+        {
+            return chunk->flags[idx] & Impl::BodyFlags::isStatic;
+        }
+        // `false` once `destroy` was called.
+        inline bool isAlive() const noexcept
+        {
+            return chunk->flags[idx] & Impl::BodyFlags::alive;
+        }
+        inline bool isAsleep() const noexcept
+        {
+            return chunk->flags[idx] & Impl::BodyFlags::asleep;
+        }
+        inline bool isContinuous() const noexcept
+        {
+            return chunk->flags[idx] & Impl::BodyFlags::continuous;
+        }
         inline bool hasMovedLeft() const noexcept
         {
             return getShape().getX() < getOldShape().getX();
@@ -258,6 +631,9 @@ namespace ssvsc
             return data.restitution.y;
         }
 
+        // Dense index, unique among the living bodies of a world.
+        inline SizeT getSlot() const noexcept { return slot; }
+
         inline void* getUserData() const noexcept { return userData; }
         template <typename T>
         inline T getUserData() const noexcept
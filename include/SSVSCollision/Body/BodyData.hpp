@@ -9,18 +9,10 @@ namespace ssvsc
 {
     struct BodyData
     {
-        AABB shape, oldShape;
-        Vec2f velocity, oldVelocity, acceleration, restitution;
+        Vec2f restitution;
         Vec2i lastResolution;
         float mass{1.f}, invMass{1.f};
-        bool _static, resolve{true};
-
-        inline BodyData(bool mIsStatic, const Vec2i& mPos,
-            const Vec2i& mSize) noexcept : shape{mPos, mSize / 2},
-                                           oldShape{shape},
-                                           _static{mIsStatic}
-        {
-        }
+        bool resolve{true};
 
         inline void setMass(float mX) noexcept
         {
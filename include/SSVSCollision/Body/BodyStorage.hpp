@@ -0,0 +1,240 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_BODY_BODYSTORAGE
+#define SSVSC_BODY_BODYSTORAGE
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        namespace BodyFlags
+        {
+            constexpr std::uint8_t alive{1 << 0};
+            constexpr std::uint8_t isStatic{1 << 1};
+            // Set for the bodies that `BodyStorage::integrate` must move.
+            constexpr std::uint8_t integrate{1 << 2};
+            // Set while the body sleeps, see `SleepSettings`.
+            constexpr std::uint8_t asleep{1 << 3};
+            // Set for the bodies detecting collisions in the current
+            // update.
+            constexpr std::uint8_t detecting{1 << 4};
+            // Set for the bodies swept against what they resolve against,
+            // see `Body::setContinuous`.
+            constexpr std::uint8_t continuous{1 << 5};
+        }
+
+        // Structure-of-arrays storage of the hot body state, owned by
+        // `World`. Every body is a handle to one slot. Slots are grouped
+        // in fixed-size chunks, so the arrays are contiguous inside a chunk
+        // and references to a slot's data are never invalidated by the
+        // creation of other bodies.
+        class BodyStorage
+        {
+        public:
+            static constexpr SizeT chunkSize{256};
+
+            struct Chunk
+            {
+                AABB shapes[chunkSize], oldShapes[chunkSize];
+                // Positions before the last substep of `World::advance`,
+                // stamped with the `World::advance` call that saved them.
+                Vec2i prevPositions[chunkSize];
+                SizeT prevSteps[chunkSize];
+                Vec2f velocities[chunkSize], oldVelocities[chunkSize],
+                    accelerations[chunkSize];
+                std::uint8_t flags[chunkSize];
+            };
+
+        private:
+            std::vector<UPtr<Chunk>> chunks;
+            // Number of slots flagged with `BodyFlags::integrate` in every
+            // chunk: the others are skipped by `integrate`.
+            std::vector<SizeT> toIntegrate;
+            SlotAllocator slots;
+            // Bumped whenever a slot is acquired or killed: while it does
+            // not change, the same slots stay alive.
+            SizeT changes{0};
+
+            inline static void integrateScalar(
+                Chunk& mC, SizeT mBegin, SizeT mEnd, FT mFT) noexcept
+            {
+                for(auto i(mBegin); i < mEnd; ++i)
+                {
+                    if(!(mC.flags[i] & BodyFlags::integrate)) continue;
+
+                    mC.velocities[i] += mC.accelerations[i] * mFT;
+                    mC.shapes[i].move(Vec2i(mC.velocities[i] * mFT));
+                    ssvs::nullify(mC.accelerations[i]);
+                }
+            }
+
+#if defined(__SSE2__)
+            // Two bodies per iteration: velocities and accelerations are
+            // stored as interleaved `x, y` floats, so a 128-bit lane holds
+            // exactly two of them.
+            inline static void integrateSSE(Chunk& mC, FT mFT) noexcept
+            {
+                static_assert(sizeof(Vec2f) == 2 * sizeof(float), "");
+                static_assert(chunkSize % 2 == 0, "");
+
+                auto* vel(reinterpret_cast<float*>(mC.velocities));
+                auto* acc(reinterpret_cast<float*>(mC.accelerations));
+                const __m128 ft{_mm_set1_ps(mFT)};
+                alignas(16) int offsets[4];
+
+                for(SizeT i{0}; i < chunkSize; i += 2)
+                {
+                    const bool m0(mC.flags[i] & BodyFlags::integrate);
+                    const bool m1(mC.flags[i + 1] & BodyFlags::integrate);
+                    if(!m0 && !m1) continue;
+
+                    const __m128 mask{_mm_castsi128_ps(_mm_set_epi32(
+                        -int(m1), -int(m1), -int(m0), -int(m0)))};
+
+                    const __m128 v{_mm_loadu_ps(vel + i * 2)};
+                    const __m128 a{_mm_loadu_ps(acc + i * 2)};
+                    const __m128 newV{_mm_add_ps(v, _mm_mul_ps(a, ft))};
+
+                    _mm_storeu_ps(vel + i * 2,
+                        _mm_or_ps(_mm_and_ps(mask, newV),
+                                      _mm_andnot_ps(mask, v)));
+                    _mm_storeu_ps(acc + i * 2, _mm_andnot_ps(mask, a));
+
+                    // Truncation, like the `Vec2i(Vec2f)` conversion.
+                    _mm_store_si128(reinterpret_cast<__m128i*>(offsets),
+                        _mm_cvttps_epi32(_mm_mul_ps(newV, ft)));
+
+                    if(m0) mC.shapes[i].move({offsets[0], offsets[1]});
+                    if(m1) mC.shapes[i + 1].move({offsets[2], offsets[3]});
+                }
+            }
+#endif
+
+        public:
+            inline SizeT acquire(
+                bool mIsStatic, const Vec2i& mPos, const Vec2i& mSize)
+            {
+                const auto slot(slots.acquire());
+                if(slot / chunkSize >= chunks.size())
+                {
+                    chunks.emplace_back(std::make_unique<Chunk>());
+                    toIntegrate.emplace_back(0);
+                }
+
+                auto& c(getChunk(slot));
+                const auto i(getIdx(slot));
+
+                c.shapes[i] = AABB{mPos, mSize / 2};
+                c.oldShapes[i] = c.shapes[i];
+                c.prevPositions[i] = mPos;
+                c.prevSteps[i] = 0;
+                ssvs::nullify(c.velocities[i]);
+                ssvs::nullify(c.oldVelocities[i]);
+                ssvs::nullify(c.accelerations[i]);
+                c.flags[i] = BodyFlags::alive;
+                if(mIsStatic) c.flags[i] |= BodyFlags::isStatic;
+
+                ++changes;
+                return slot;
+            }
+            // Clears the alive flag of `mSlot`. Only the first call counts.
+            inline void kill(SizeT mSlot) noexcept
+            {
+                auto& f(getChunk(mSlot).flags[getIdx(mSlot)]);
+                if(!(f & BodyFlags::alive)) return;
+
+                f &= ~BodyFlags::alive;
+                ++changes;
+            }
+            inline void release(SizeT mSlot)
+            {
+                getChunk(mSlot).flags[getIdx(mSlot)] = 0;
+                slots.release(mSlot);
+            }
+
+            inline Chunk& getChunk(SizeT mSlot) noexcept
+            {
+                SSVU_ASSERT(mSlot / chunkSize < chunks.size());
+                return *chunks[mSlot / chunkSize];
+            }
+            inline static SizeT getIdx(SizeT mSlot) noexcept
+            {
+                return mSlot % chunkSize;
+            }
+            inline SizeT getCapacity() const noexcept
+            {
+                return slots.getCapacity();
+            }
+            inline SizeT getChanges() const noexcept { return changes; }
+
+            // Copies every chunk to `mOut`, for `World::saveState`.
+            inline void save(std::vector<Chunk>& mOut) const
+            {
+                mOut.resize(chunks.size());
+                for(SizeT i{0}; i < chunks.size(); ++i) mOut[i] = *chunks[i];
+            }
+            // Copies back the slots alive in `mIn`: the others may have
+            // been acquired since. `BodyFlags::integrate` is kept, so that
+            // `toIntegrate` stays exact.
+            inline void load(const std::vector<Chunk>& mIn) noexcept
+            {
+                SSVU_ASSERT(mIn.size() <= chunks.size());
+                for(SizeT iC{0}; iC < mIn.size(); ++iC)
+                {
+                    const auto& in(mIn[iC]);
+                    auto& c(*chunks[iC]);
+
+                    for(SizeT i{0}; i < chunkSize; ++i)
+                    {
+                        if(!(in.flags[i] & BodyFlags::alive)) continue;
+
+                        c.shapes[i] = in.shapes[i];
+                        c.oldShapes[i] = in.oldShapes[i];
+                        c.prevPositions[i] = in.prevPositions[i];
+                        c.prevSteps[i] = in.prevSteps[i];
+                        c.velocities[i] = in.velocities[i];
+                        c.oldVelocities[i] = in.oldVelocities[i];
+                        c.accelerations[i] = in.accelerations[i];
+                        c.flags[i] = (in.flags[i] & ~BodyFlags::integrate) |
+                                     (c.flags[i] & BodyFlags::integrate);
+                    }
+                }
+            }
+
+            // Flags `mSlot` for the next `integrate`.
+            inline void markIntegrate(SizeT mSlot) noexcept
+            {
+                auto& f(getChunk(mSlot).flags[getIdx(mSlot)]);
+                if(f & BodyFlags::integrate) return;
+
+                f |= BodyFlags::integrate;
+                ++toIntegrate[mSlot / chunkSize];
+            }
+
+            // Integrates every slot flagged with `BodyFlags::integrate` and
+            // clears the flag: `velocity += acceleration * mFT`, then the
+            // shape moves by `velocity * mFT` and the acceleration is reset.
+            // Chunks without a flagged slot are not looked at.
+            inline void integrate(FT mFT) noexcept
+            {
+                for(SizeT i{0}; i < chunks.size(); ++i)
+                {
+                    if(toIntegrate[i] == 0) continue;
+
+                    auto& c(*chunks[i]);
+#if defined(__SSE2__)
+                    integrateSSE(c, mFT);
+#else
+                    integrateScalar(c, 0, chunkSize, mFT);
+#endif
+                    for(auto& f : c.flags) f &= ~BodyFlags::integrate;
+                    toIntegrate[i] = 0;
+                }
+            }
+        };
+    }
+}
+
+#endif
@@ -7,15 +7,28 @@
 
 namespace ssvsc
 {
-    class Groupable
+    // `TDerived` is told when `groups` change, through
+    // `onGroupsChanged()`: spatial backends may index bodies by group.
+    template <typename TDerived, SizeT TGroupCount>
+    class GroupableOf
     {
+    public:
+        using GroupBitsetType = GroupBitsetOf<TGroupCount>;
+
     private:
-        GroupBitset groups, groupsToCheck, groupsNoResolve;
+        GroupBitsetType groups, groupsToCheck, groupsNoResolve;
+
+        inline void notifyGroups() noexcept
+        {
+            static_cast<TDerived&>(*this).onGroupsChanged();
+        }
 
     public:
         inline void setGroups(bool mOn, Group mGroup) noexcept
         {
+            SSVU_ASSERT(mGroup < TGroupCount);
             groups[mGroup] = mOn;
+            notifyGroups();
         }
         inline void addGroups(Group mGroup) noexcept
         {
@@ -47,6 +60,7 @@ namespace ssvsc
 
         inline void setGroupsToCheck(bool mOn, Group mGroup) noexcept
         {
+            SSVU_ASSERT(mGroup < TGroupCount);
             groupsToCheck[mGroup] = mOn;
         }
         inline void addGroupsToCheck(Group mGroup) noexcept
@@ -79,6 +93,7 @@ namespace ssvsc
 
         inline void setGroupsNoResolve(bool mOn, Group mGroup) noexcept
         {
+            SSVU_ASSERT(mGroup < TGroupCount);
             groupsNoResolve[mGroup] = mOn;
         }
         inline void addGroupsNoResolve(Group mGroup) noexcept
@@ -111,7 +126,21 @@ namespace ssvsc
             delGroupsNoResolve(mGroups...);
         }
 
-        inline void clearGroups() noexcept { groups.reset(); }
+        // Copies the three group sets of `mOther`.
+        inline void copyGroups(const GroupableOf& mOther) noexcept
+        {
+            const bool changed{groups != mOther.groups};
+            groups = mOther.groups;
+            groupsToCheck = mOther.groupsToCheck;
+            groupsNoResolve = mOther.groupsNoResolve;
+            if(changed) notifyGroups();
+        }
+
+        inline void clearGroups() noexcept
+        {
+            groups.reset();
+            notifyGroups();
+        }
         inline void clearGroupsToCheck() noexcept { groupsToCheck.reset(); }
         inline void clearGroupsNoResolve() noexcept { groupsNoResolve.reset(); }
 
@@ -128,31 +157,31 @@ namespace ssvsc
             return groupsNoResolve[mGroup];
         }
 
-        inline bool hasAnyGroup(const GroupBitset& mGroups) const noexcept
+        inline bool hasAnyGroup(const GroupBitsetType& mGroups) const noexcept
         {
             return (groups & mGroups).any();
         }
-        inline bool hasAnyGroupToCheck(const GroupBitset& mGroups) const
+        inline bool hasAnyGroupToCheck(const GroupBitsetType& mGroups) const
             noexcept
         {
             return (groupsToCheck & mGroups).any();
         }
-        inline bool hasAnyGroupNoResolve(const GroupBitset& mGroups) const
+        inline bool hasAnyGroupNoResolve(const GroupBitsetType& mGroups) const
             noexcept
         {
             return (groupsNoResolve & mGroups).any();
         }
 
-        inline bool hasAllGroups(const GroupBitset& mGroups) const noexcept
+        inline bool hasAllGroups(const GroupBitsetType& mGroups) const noexcept
         {
             return (groups & mGroups).all();
         }
-        inline bool hasAllGroupsToCheck(const GroupBitset& mGroups) const
+        inline bool hasAllGroupsToCheck(const GroupBitsetType& mGroups) const
             noexcept
         {
             return (groupsToCheck & mGroups).all();
         }
-        inline bool hasAllGroupsNoResolve(const GroupBitset& mGroups) const
+        inline bool hasAllGroupsNoResolve(const GroupBitsetType& mGroups) const
             noexcept
         {
             return (groupsNoResolve & mGroups).all();
@@ -168,6 +197,17 @@ namespace ssvsc
             return groupsNoResolve;
         }
     };
+
+    // Group sets of the default width that nothing listens to, as
+    // `Groupable` was before bodies took their width from `World`. Bodies
+    // derive from `GroupableOf` instead.
+    class Groupable : public GroupableOf<Groupable, maxGroups>
+    {
+        friend GroupableOf<Groupable, maxGroups>;
+
+    private:
+        inline void onGroupsChanged() const noexcept {}
+    };
 }
 
 #endif
@@ -39,9 +39,11 @@ namespace ssvsc
         }
         inline void handleCollision(FT mFT, Body<TW>* mBody)
         {
-            if(!this->mustCheck(*mBody) ||
-                !shape.isOverlapping(mBody->getShape()))
-                return;
+            if(!this->mustCheck(*mBody)) return;
+
+            ++this->world.stats.pairTests;
+            if(!shape.isOverlapping(mBody->getShape())) return;
+
             this->onDetection({*mBody, mBody->getUserData(), mFT});
         }
 
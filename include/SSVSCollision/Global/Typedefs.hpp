@@ -14,9 +14,12 @@ namespace ssvsc
     using ssvs::Vec2f;
     using ssvs::UPtr;
 
+    // Default number of groups of a `World`, see its `TGroupCount`.
     constexpr SizeT maxGroups{32};
     using Group = unsigned int;
-    using GroupBitset = std::bitset<maxGroups>;
+    template <SizeT TGroupCount>
+    using GroupBitsetOf = std::bitset<TGroupCount>;
+    using GroupBitset = GroupBitsetOf<maxGroups>;
 
     enum class QueryType
     {
@@ -26,7 +29,9 @@ namespace ssvsc
         OrthoLeft,
         OrthoRight,
         OrthoUp,
-        OrthoDown
+        OrthoDown,
+        Area,
+        Nearest
     };
     enum class QueryMode
     {
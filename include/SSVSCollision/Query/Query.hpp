@@ -15,6 +15,80 @@ namespace ssvsc
     template <typename TW, typename TS, QueryMode TMode>
     struct QueryModeDispatcher;
 
+    namespace Impl
+    {
+        // Candidate buffers shared by the queries of a world. A query takes
+        // a buffer when created and gives it back, emptied but with its
+        // capacity, when destroyed: once warmed up, queries do not
+        // allocate.
+        template <typename T>
+        class ScratchPool
+        {
+        private:
+            std::vector<std::vector<T>> buffers;
+            std::mutex mutex;
+
+        public:
+            inline std::vector<T> acquire()
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                if(buffers.empty()) return {};
+
+                auto result(std::move(buffers.back()));
+                buffers.pop_back();
+                return result;
+            }
+            inline void release(std::vector<T>&& mBuffer)
+            {
+                mBuffer.clear();
+                std::lock_guard<std::mutex> lock{mutex};
+                buffers.emplace_back(std::move(mBuffer));
+            }
+        };
+
+        // Yields the next body of `mInternal`, using `mBodies` as the
+        // candidate stack of the current step.
+        template <typename TMode, typename TBody, typename TInternal,
+            typename... TArgs>
+        inline TBody* nextBody(std::vector<TBody*>& mBodies,
+            TInternal& mInternal, TArgs&&... mArgs)
+        {
+            while(true)
+            {
+                // If the body stack is empty, 'refill' it: `TMode::getBodies`
+                // appends the candidates, then they are sorted in place.
+                // The candidates of the last step are yielded even though
+                // the query is no longer valid.
+                if(mBodies.empty())
+                {
+                    if(!mInternal.isValid()) return nullptr;
+
+                    TMode::getBodies(mBodies, mInternal, FWD(mArgs)...);
+                    if(mBodies.size() > 1)
+                        ssvu::sort(mBodies,
+                            [&mInternal](const TBody* mA, const TBody* mB)
+                            {
+                                return mInternal.getSorting(mA, mB);
+                            });
+                    mInternal.step();
+                }
+
+                // While the body stack is not empty, 'yield' bodies one by one
+                while(!mBodies.empty())
+                {
+                    TBody* body{mBodies.back()};
+                    const auto& shape(body->getShape());
+                    mBodies.pop_back();
+
+                    if(!mInternal.hits(shape)) continue;
+
+                    mInternal.setOut(shape);
+                    return body;
+                }
+            }
+        }
+    }
+
     template <typename TW, typename TInternal, typename TMode>
     class Query
     {
@@ -23,48 +97,45 @@ namespace ssvsc
         friend TInternal;
 
     private:
+        Impl::ScratchPool<BodyType*>* pool;
+        // Candidates of the current step, filtered by `TMode`, in reverse
+        // yield order.
         std::vector<BodyType*> bodies;
         TInternal internal;
 
     public:
         template <typename... TArgs>
-        inline Query(TArgs&&... mArgs) noexcept : internal{FWD(mArgs)...}
+        inline Query(Impl::ScratchPool<BodyType*>& mPool, TArgs&&... mArgs)
+            : pool{&mPool}, bodies{mPool.acquire()}, internal{FWD(mArgs)...}
         {
         }
-        template <typename... TArgs>
-        BodyType* next(TArgs&&... mArgs)
+        inline Query(Query&& mQuery) noexcept
+            : pool{mQuery.pool}, bodies{std::move(mQuery.bodies)},
+              internal{std::move(mQuery.internal)}
         {
-            while(internal.isValid())
-            {
-                // If the body stack is empty, 'refill' it using
-                // TMode::getBodies,
-                // then sort
-                if(bodies.empty())
-                {
-                    TMode::getBodies(bodies, internal, FWD(mArgs)...);
-                    ssvu::sort(bodies,
-                        [this](const BodyType* mA, const BodyType* mB)
-                        {
-                            return internal.getSorting(mA, mB);
-                        });
-                    internal.step();
-                }
-
-                // While the body stack is not empty, 'yield' bodies one by one
-                while(!bodies.empty())
-                {
-                    BodyType* body{bodies.back()};
-                    const auto& shape(body->getShape());
-                    bodies.pop_back();
+            mQuery.pool = nullptr;
+        }
+        inline ~Query()
+        {
+            if(pool != nullptr) pool->release(std::move(bodies));
+        }
 
-                    if(!internal.hits(shape)) continue;
+        Query(const Query&) = delete;
+        Query& operator=(const Query&) = delete;
+        Query& operator=(Query&&) = delete;
 
-                    internal.setOut(shape);
-                    return body;
-                }
-            }
+        template <typename... TArgs>
+        BodyType* next(TArgs&&... mArgs)
+        {
+            return Impl::nextBody<TMode>(bodies, internal, FWD(mArgs)...);
+        }
 
-            return nullptr;
+        // First body hit by a `RayCast` query, found without sorting the
+        // candidates. Sets the last position but does not move the query.
+        template <typename... TArgs>
+        BodyType* firstHit(const TArgs&... mArgs)
+        {
+            return internal.template firstHit<TMode>(mArgs...);
         }
 
         inline void reset()
@@ -0,0 +1,133 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_QUERY_QUERYBATCH
+#define SSVSC_QUERY_QUERYBATCH
+
+namespace ssvsc
+{
+    template <typename TW>
+    class Body;
+
+    // Requests of `World::runQueries`: the arguments of the matching
+    // `World::getQuery` calls.
+    struct PointRequest
+    {
+        Vec2i pos;
+    };
+    struct DistanceRequest
+    {
+        Vec2i pos;
+        int distance;
+    };
+    struct RayRequest
+    {
+        Vec2i pos;
+        Vec2f dir;
+    };
+
+    // Body found by a query of a batch, or `nullptr`. `pos` is where
+    // it was found: the point itself, the closest point of the body's shape
+    // or where the ray enters it. `distance` is its distance from the
+    // position of the request.
+    template <typename TW>
+    struct QueryHit
+    {
+        Body<TW>* body{nullptr};
+        Vec2f pos;
+        float distance{0.f};
+    };
+
+    namespace Impl
+    {
+        template <typename TRequest>
+        struct RequestTraits;
+
+        template <>
+        struct RequestTraits<PointRequest>
+        {
+            static constexpr QueryType type{QueryType::Point};
+
+            template <typename T, typename TS>
+            inline static T make(const TS& mSpatial, const PointRequest& mR)
+            {
+                return T{mSpatial, mR.pos};
+            }
+            template <typename TMode, typename TW, typename TInternal,
+                typename... TArgs>
+            inline static void find(QueryHit<TW>& mHit,
+                std::vector<Body<TW>*>& mBodies, TInternal& mInternal,
+                const PointRequest& mR, const TArgs&... mArgs)
+            {
+                mHit.body = nextBody<TMode>(mBodies, mInternal, mArgs...);
+                mHit.pos = Vec2f(mR.pos);
+            }
+        };
+        template <>
+        struct RequestTraits<DistanceRequest>
+        {
+            static constexpr QueryType type{QueryType::Distance};
+
+            template <typename T, typename TS>
+            inline static T make(
+                const TS& mSpatial, const DistanceRequest& mR)
+            {
+                return T{mSpatial, mR.pos, mR.distance};
+            }
+            // Candidates are yielded by cell and sorted by centre: a big
+            // body can be closer than the first one. All of them are
+            // scanned for the closest shape, like `QueryType::Nearest`.
+            template <typename TMode, typename TW, typename TInternal,
+                typename... TArgs>
+            inline static void find(QueryHit<TW>& mHit,
+                std::vector<Body<TW>*>& mBodies, TInternal& mInternal,
+                const DistanceRequest& mR, const TArgs&... mArgs)
+            {
+                const Vec2f pos(mR.pos);
+                float bestSq{ssvu::NumLimits<float>::max()};
+
+                mHit.body = nullptr;
+                while(auto* b = nextBody<TMode>(mBodies, mInternal, mArgs...))
+                {
+                    const auto distSq(
+                        Utils::getDistSquared(b->getShape(), pos));
+                    if(distSq >= bestSq) continue;
+
+                    bestSq = distSq;
+                    mHit.body = b;
+                }
+
+                mHit.pos = mHit.body == nullptr
+                               ? pos
+                               : Utils::getClosestPoint(
+                                     mHit.body->getShape(), pos);
+            }
+        };
+        template <>
+        struct RequestTraits<RayRequest>
+        {
+            static constexpr QueryType type{QueryType::RayCast};
+
+            template <typename T, typename TS>
+            inline static T make(const TS& mSpatial, const RayRequest& mR)
+            {
+                return T{mSpatial, mR.pos, mR.dir};
+            }
+            // Candidates are yielded by cell, not by entry: the first one
+            // is not necessarily the first hit.
+            template <typename TMode, typename TW, typename TInternal,
+                typename... TArgs>
+            inline static void find(QueryHit<TW>& mHit,
+                std::vector<Body<TW>*>&, TInternal& mInternal,
+                const RayRequest& mR, const TArgs&... mArgs)
+            {
+                mHit.body = mInternal.template firstHit<TMode>(mArgs...);
+                mHit.pos = mHit.body == nullptr ? Vec2f(mR.pos)
+                                                : mInternal.getLastPos();
+            }
+        };
+    }
+}
+
+#endif
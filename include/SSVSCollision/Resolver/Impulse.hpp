@@ -118,11 +118,7 @@ namespace ssvsc
             AABB& shape(mBody.getShape());
             const AABB& oldShape(mBody.getOldShape());
 
-            ssvu::sort(mToResolve, [&shape](BodyType* mA, BodyType* mB)
-                {
-                    return Utils::getOverlapArea(shape, mA->getShape()) >
-                           Utils::getOverlapArea(shape, mB->getShape());
-                });
+            Utils::sortByOverlap(shape, mToResolve);
             int resXNeg{0}, resXPos{0}, resYNeg{0}, resYPos{0};
             constexpr int tolerance{20};
 
@@ -154,8 +150,8 @@ namespace ssvsc
                 Vec2i resolution{
                     std::abs(iX) < std::abs(iY) ? Vec2i{iX, 0} : Vec2i{0, iY}};
 
-                mBody.onResolution({*b, b->getUserData(), resolution,
-                    noResolvePosition, noResolveVelocity});
+                mBody.notifyResolution(
+                    *b, resolution, noResolvePosition, noResolveVelocity);
 
                 if(!noResolvePosition) mBody.resolvePosition(resolution);
                 if(noResolveVelocity) continue;
@@ -248,8 +244,11 @@ namespace ssvsc
         }
         inline void postUpdate(TW& mWorld) const
         {
-            for(const auto& b : mWorld.getBodies())
+            // Statics have no mass: their stress and impulses stay null.
+            for(const auto& b : mWorld.getDynamicBodies())
             {
+                if(b->isAsleep()) continue;
+
                 b->stress = ssvs::getCClamped(b->nextStress,
                     ssvu::NumLimits<float>::min(),
                     ssvu::NumLimits<float>::max());
@@ -37,11 +37,7 @@ namespace ssvsc
         {
             AABB& shape(mBody.getShape());
             const AABB& oldShape(mBody.getOldShape());
-            ssvu::sort(mToResolve, [&shape](BodyType* mA, BodyType* mB)
-                {
-                    return Utils::getOverlapArea(shape, mA->getShape()) >
-                           Utils::getOverlapArea(shape, mB->getShape());
-                });
+            Utils::sortByOverlap(shape, mToResolve);
 
             for(const auto& b : mToResolve)
             {
@@ -53,8 +49,8 @@ namespace ssvsc
                 Vec2i resolution{
                     std::abs(iX) < std::abs(iY) ? Vec2i{iX, 0} : Vec2i{0, iY}};
                 bool noResolvePosition{false}, noResolveVelocity{false};
-                mBody.onResolution({*b, b->getUserData(), resolution,
-                    noResolvePosition, noResolveVelocity});
+                mBody.notifyResolution(
+                    *b, resolution, noResolvePosition, noResolveVelocity);
 
                 if(!noResolvePosition) mBody.resolvePosition(resolution);
                 if(noResolveVelocity) continue;
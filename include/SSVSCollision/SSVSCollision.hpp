@@ -5,19 +5,37 @@
 #ifndef SSVSCOLLISION
 #define SSVSCOLLISION
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <queue>
+#include <thread>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <SSVUtils/SSVUtils.hpp>
 #include <SSVStart/SSVStart.hpp>
 #include "SSVSCollision/Global/Typedefs.hpp"
 #include "SSVSCollision/Utils/Segment.hpp"
 #include "SSVSCollision/Utils/Utils.hpp"
+#include "SSVSCollision/Utils/ThreadPool.hpp"
+#include "SSVSCollision/Utils/SlotAllocator.hpp"
+#include "SSVSCollision/Utils/PaintContext.hpp"
+#include "SSVSCollision/Utils/RingTable.hpp"
 #include "SSVSCollision/AABB/AABB.hpp"
+#include "SSVSCollision/Utils/UtilsAABB.hpp"
+#include "SSVSCollision/Utils/NearestHeap.hpp"
 #include "SSVSCollision/Body/Body.hpp"
 #include "SSVSCollision/Query/Query.hpp"
+#include "SSVSCollision/Query/QueryBatch.hpp"
 #include "SSVSCollision/World/World.hpp"
-#include "SSVSCollision/Utils/UtilsAABB.hpp"
 #include "SSVSCollision/Resolver/Resolver.hpp"
 #include "SSVSCollision/Spatial/Grid/Grid.hpp"
+#include "SSVSCollision/Spatial/Grid/ChunkedGrid.hpp"
+#include "SSVSCollision/Spatial/SAP/SweepAndPrune.hpp"
+#include "SSVSCollision/Spatial/DynamicTree/DynamicTree.hpp"
+#include "SSVSCollision/Spatial/MultiGrid/MultiGrid.hpp"
 #include "SSVSCollision/Query/Query.hpp"
 
 #endif
@@ -0,0 +1,491 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_BOUNDSQUERYTYPES
+#define SSVSC_SPATIAL_BOUNDSQUERYTYPES
+
+namespace ssvsc
+{
+    // Query types for spatial backends that are not made of cells.
+    // The backend must provide `forEachInBounds(const AABB&, f)`,
+    // `forEachOnSegment(start, end, f)` and `getBounds()`. Every query
+    // gathers all of its candidates in a single step, then `Query` sorts
+    // and filters them like it does for a cell. A second, empty step keeps
+    // the query valid until the candidates of the first one have all been
+    // yielded.
+    namespace BoundsQueryTypes
+    {
+        template <typename TW, typename TS>
+        struct Base
+        {
+            const TS& spatial;
+            Vec2f startPos, pos, lastPos;
+            SizeT steps{0};
+
+            Base(const TS& mSpatial, const Vec2i& mPos)
+                : spatial(mSpatial), startPos{mPos}, pos{mPos}
+            {
+            }
+
+            inline void reset() noexcept
+            {
+                pos = startPos;
+                steps = 0;
+            }
+            inline const auto& getLastPos() const noexcept { return lastPos; }
+
+            inline bool isValid() const noexcept { return steps < 2; }
+            inline void step() noexcept { ++steps; }
+
+            template <typename TF>
+            inline void gatherIn(const AABB& mArea,
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                if(steps > 0) return;
+
+                spatial.forEachInBounds(mArea, [&mBodies, &mPred](
+                                                   Body<TW>* mBody)
+                    {
+                        if(mPred(mBody)) mBodies.emplace_back(mBody);
+                    });
+            }
+        };
+
+        namespace Bodies
+        {
+            template <typename TW>
+            struct All
+            {
+                inline static bool accepts(const Body<TW>*) noexcept
+                {
+                    return true;
+                }
+
+                template <typename T>
+                inline static void getBodies(
+                    std::vector<Body<TW>*>& mBodies, const T& mInternal)
+                {
+                    mInternal.gather(mBodies, [](const Body<TW>* mBody)
+                        {
+                            return accepts(mBody);
+                        });
+                }
+            };
+            template <typename TW>
+            struct ByGroup
+            {
+                inline static bool accepts(
+                    const Body<TW>* mBody, Group mGroup) noexcept
+                {
+                    return mBody->hasGroup(mGroup);
+                }
+
+                template <typename T>
+                inline static void getBodies(std::vector<Body<TW>*>& mBodies,
+                    const T& mInternal, Group mGroup)
+                {
+                    mInternal.gather(mBodies, [mGroup](const Body<TW>* mBody)
+                        {
+                            return accepts(mBody, mGroup);
+                        });
+                }
+            };
+        }
+
+        template <typename TW, typename TS>
+        struct OrthoLeft : public Base<TW, TS>
+        {
+            template <typename... TArgs>
+            OrthoLeft(TArgs&&... mArgs)
+                : Base<TW, TS>(FWD(mArgs)...)
+            {
+            }
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                const Vec2i p(this->pos);
+                this->gatherIn(
+                    AABB{std::min(this->spatial.getBounds().getLeft(), p.x),
+                        p.x, p.y, p.y},
+                    mBodies, mPred);
+            }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return mA->getPosition().x < mB->getPosition().x;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.getLeft() <= this->pos.x &&
+                       this->pos.y >= mShape.getTop() &&
+                       this->pos.y <= mShape.getBottom();
+            }
+            inline void setOut(const AABB& mShape)
+            {
+                this->lastPos = Vec2f(mShape.getRight(), this->pos.y);
+            }
+        };
+        template <typename TW, typename TS>
+        struct OrthoRight : public Base<TW, TS>
+        {
+            template <typename... TArgs>
+            OrthoRight(TArgs&&... mArgs)
+                : Base<TW, TS>(FWD(mArgs)...)
+            {
+            }
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                const Vec2i p(this->pos);
+                this->gatherIn(
+                    AABB{p.x,
+                        std::max(this->spatial.getBounds().getRight(), p.x),
+                        p.y, p.y},
+                    mBodies, mPred);
+            }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return mA->getPosition().x > mB->getPosition().x;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.getRight() >= this->pos.x &&
+                       this->pos.y >= mShape.getTop() &&
+                       this->pos.y <= mShape.getBottom();
+            }
+            inline void setOut(const AABB& mShape)
+            {
+                this->lastPos = Vec2f(mShape.getLeft(), this->pos.y);
+            }
+        };
+        template <typename TW, typename TS>
+        struct OrthoUp : public Base<TW, TS>
+        {
+            template <typename... TArgs>
+            OrthoUp(TArgs&&... mArgs)
+                : Base<TW, TS>(FWD(mArgs)...)
+            {
+            }
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                const Vec2i p(this->pos);
+                this->gatherIn(
+                    AABB{p.x, p.x,
+                        std::min(this->spatial.getBounds().getTop(), p.y),
+                        p.y},
+                    mBodies, mPred);
+            }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return mA->getPosition().y < mB->getPosition().y;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.getTop() <= this->pos.y &&
+                       this->pos.x >= mShape.getLeft() &&
+                       this->pos.x <= mShape.getRight();
+            }
+            inline void setOut(const AABB& mShape)
+            {
+                this->lastPos = Vec2f(this->pos.x, mShape.getBottom());
+            }
+        };
+        template <typename TW, typename TS>
+        struct OrthoDown : public Base<TW, TS>
+        {
+            template <typename... TArgs>
+            OrthoDown(TArgs&&... mArgs)
+                : Base<TW, TS>(FWD(mArgs)...)
+            {
+            }
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                const Vec2i p(this->pos);
+                this->gatherIn(
+                    AABB{p.x, p.x, p.y,
+                        std::max(this->spatial.getBounds().getBottom(), p.y)},
+                    mBodies, mPred);
+            }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return mA->getPosition().y > mB->getPosition().y;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.getBottom() >= this->pos.y &&
+                       this->pos.x >= mShape.getLeft() &&
+                       this->pos.x <= mShape.getRight();
+            }
+            inline void setOut(const AABB& mShape)
+            {
+                this->lastPos = Vec2f(this->pos.x, mShape.getTop());
+            }
+        };
+
+        template <typename TW, typename TS>
+        struct Point : public Base<TW, TS>
+        {
+            template <typename... TArgs>
+            Point(TArgs&&... mArgs)
+                : Base<TW, TS>(FWD(mArgs)...)
+            {
+            }
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                this->gatherIn(
+                    AABB{Vec2i(this->pos), Vec2i{0, 0}}, mBodies, mPred);
+            }
+            // Unordered: `std::sort` needs a strict weak ordering.
+            inline bool getSorting(const Body<TW>*, const Body<TW>*)
+            {
+                return false;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.contains(Vec2i(this->pos));
+            }
+            inline void setOut(const AABB&) { this->lastPos = this->pos; }
+        };
+
+        template <typename TW, typename TS>
+        struct Area : public Base<TW, TS>
+        {
+            AABB area;
+
+            Area(const TS& mSpatial, const AABB& mArea)
+                : Base<TW, TS>{mSpatial, mArea.getPosition()}, area{mArea}
+            {
+            }
+
+            // Number of bodies accepted by `TMode` overlapping `area`,
+            // without gathering them.
+            template <typename TMode, typename... TArgs>
+            inline SizeT count(const TArgs&... mArgs) const
+            {
+                SizeT result{0};
+                this->spatial.forEachInBounds(area, [&](const Body<TW>* mBody)
+                    {
+                        if(TMode::accepts(mBody, mArgs...) &&
+                            mBody->getShape().isOverlapping(area))
+                            ++result;
+                    });
+
+                return result;
+            }
+
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                this->gatherIn(area, mBodies, mPred);
+            }
+            inline bool getSorting(const Body<TW>*, const Body<TW>*)
+            {
+                return false;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.isOverlapping(area);
+            }
+            inline void setOut(const AABB&) { this->lastPos = this->pos; }
+        };
+
+        // Gathers the `k` bodies closest to the start position in a single
+        // step, over squares doubling in size until the farthest of them
+        // is nearer than the square side or the square covers the bounds.
+        template <typename TW, typename TS>
+        struct Nearest : public Base<TW, TS>
+        {
+            SizeT k;
+
+            Nearest(const TS& mSpatial, const Vec2i& mPos, SizeT mK)
+                : Base<TW, TS>{mSpatial, mPos}, k{mK}
+            {
+            }
+
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                if(this->steps > 0 || k == 0) return;
+
+                const auto bounds(this->spatial.getBounds());
+                const Vec2i p(this->startPos);
+                Impl::NearestHeap<Body<TW>> heap{mBodies, k, this->startPos};
+                int half{std::max(
+                    1, std::max(bounds.getWidth(), bounds.getHeight()) / 16)};
+
+                while(true)
+                {
+                    const AABB square{p, Vec2i{half, half}};
+                    this->spatial.forEachInBounds(square,
+                        [&heap, &mPred](Body<TW>* mBody)
+                        {
+                            if(mPred(mBody)) heap.add(mBody);
+                        });
+
+                    // Bodies outside the square are farther than `half`.
+                    const float bound(half);
+                    if(heap.isFull() && heap.getWorstDistSq() <= bound * bound)
+                        return;
+
+                    if(square.contains(bounds)) return;
+                    half *= 2;
+                }
+            }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return Utils::getDistSquared(mA->getShape(), this->startPos) >
+                       Utils::getDistSquared(mB->getShape(), this->startPos);
+            }
+            inline bool hits(const AABB&) { return true; }
+            inline void setOut(const AABB& mShape)
+            {
+                this->lastPos = Utils::getClosestPoint(mShape, this->startPos);
+            }
+        };
+
+        template <typename TW, typename TS>
+        struct RayCast : public Base<TW, TS>
+        {
+            Vec2f dir, endPos;
+
+            // The ray ends where it leaves the bounds of the backend.
+            RayCast(const TS& mSpatial, const Vec2i& mPos, const Vec2f& mDir)
+                : Base<TW, TS>{mSpatial, mPos}, dir{mDir}, endPos{this->pos}
+            {
+                const auto& bounds(this->spatial.getBounds());
+                const float length{
+                    ssvu::toFloat(bounds.getWidth() + bounds.getHeight()) +
+                    std::abs(this->startPos.x - bounds.getX()) +
+                    std::abs(this->startPos.y - bounds.getY())};
+                const float dirLength{
+                    std::max(std::abs(dir.x), std::abs(dir.y))};
+
+                if(dirLength != 0) endPos += dir * (length / dirLength);
+            }
+
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                if(this->steps > 0) return;
+
+                this->spatial.forEachOnSegment(this->startPos, endPos,
+                    [&mBodies, &mPred](Body<TW>* mBody)
+                    {
+                        if(mPred(mBody)) mBodies.emplace_back(mBody);
+                    });
+            }
+            // Closest body accepted by `TMode` whose near sides the ray
+            // crosses, keeping the smallest slab test entry parameter
+            // instead of sorting the candidates.
+            template <typename TMode, typename... TArgs>
+            inline Body<TW>* firstHit(const TArgs&... mArgs)
+            {
+                Body<TW>* result{nullptr};
+                float best{1.f};
+                const auto delta(endPos - this->startPos);
+
+                this->spatial.forEachOnSegment(this->startPos, endPos,
+                    [&](Body<TW>* mBody)
+                    {
+                        float t;
+                        if(TMode::accepts(mBody, mArgs...) &&
+                            Utils::isRayEntering(mBody->getShape(),
+                                this->startPos, delta, best, t) &&
+                            (t < best || result == nullptr))
+                        {
+                            result = mBody;
+                            best = t;
+                        }
+                    });
+
+                if(result != nullptr)
+                    this->lastPos = this->startPos + delta * best;
+                return result;
+            }
+
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return ssvs::getDistEuclidean(
+                           mA->getPosition(), this->startPos) >
+                       ssvs::getDistEuclidean(
+                           mB->getPosition(), this->startPos);
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                Segment<float> ray{this->startPos, endPos};
+                Vec2f intersection;
+
+                if(Utils::isSegmentInsersecting(ray,
+                       {dir.x > 0 ? mShape.getSegmentLeft<float>()
+                                  : mShape.getSegmentRight<float>()},
+                       intersection) ||
+                    Utils::isSegmentInsersecting(ray,
+                        {dir.y > 0 ? mShape.getSegmentTop<float>()
+                                   : mShape.getSegmentBottom<float>()},
+                        intersection))
+                {
+                    this->lastPos = intersection;
+                    return true;
+                }
+
+                return false;
+            }
+            inline void setOut(const AABB&) {}
+        };
+
+        template <typename TW, typename TS>
+        struct Distance : public Base<TW, TS>
+        {
+            int distance;
+
+            Distance(const TS& mSpatial, const Vec2i& mPos, int mDistance)
+                : Base<TW, TS>{mSpatial, mPos}, distance{mDistance}
+            {
+            }
+
+            template <typename TF>
+            inline void gather(
+                std::vector<Body<TW>*>& mBodies, const TF& mPred) const
+            {
+                this->gatherIn(
+                    AABB{Vec2i(this->startPos), Vec2i{distance, distance}},
+                    mBodies, mPred);
+            }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return ssvs::getDistEuclidean(
+                           mA->getPosition(), this->startPos) >
+                       ssvs::getDistEuclidean(
+                           mB->getPosition(), this->startPos);
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                Vec2i test{this->startPos.x < mShape.getX() ? mShape.getLeft()
+                                                            : mShape.getRight(),
+                    this->startPos.y < mShape.getY() ? mShape.getTop()
+                                                     : mShape.getBottom()};
+
+                if(ssvs::getDistSquaredEuclidean(test, this->startPos) >
+                    distance * distance)
+                    return false;
+
+                this->lastPos = Vec2f(test);
+                return true;
+            }
+            inline void setOut(const AABB&) {}
+        };
+    }
+}
+
+#endif
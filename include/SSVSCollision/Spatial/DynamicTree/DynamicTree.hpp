@@ -0,0 +1,538 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_DYNAMICTREE
+#define SSVSC_SPATIAL_DYNAMICTREE
+
+#include "SSVSCollision/Spatial/ProxyKind.hpp"
+#include "SSVSCollision/Spatial/DynamicTree/DynamicTreeInfo.hpp"
+#include "SSVSCollision/Spatial/BoundsQueryTypes.hpp"
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Inclusive edges: unlike `AABB`, merging two of them is exact.
+        struct TreeBounds
+        {
+            int left, right, top, bottom;
+
+            inline TreeBounds() noexcept = default;
+            inline TreeBounds(const AABB& mShape, int mMargin = 0) noexcept
+                : left{mShape.getLeft() - mMargin},
+                  right{mShape.getRight() + mMargin},
+                  top{mShape.getTop() - mMargin},
+                  bottom{mShape.getBottom() + mMargin}
+            {
+            }
+
+            inline int getLeft() const noexcept { return left; }
+            inline int getRight() const noexcept { return right; }
+            inline int getTop() const noexcept { return top; }
+            inline int getBottom() const noexcept { return bottom; }
+
+            // The insertion cost is based on the perimeter, like the
+            // surface area heuristic in 3D.
+            inline std::int64_t getPerimeter() const noexcept
+            {
+                return 2 * (std::int64_t(right) - left) +
+                       2 * (std::int64_t(bottom) - top);
+            }
+
+            inline bool contains(const TreeBounds& mX) const noexcept
+            {
+                return left <= mX.left && right >= mX.right &&
+                       top <= mX.top && bottom >= mX.bottom;
+            }
+            inline bool isOverlapping(const TreeBounds& mX) const noexcept
+            {
+                return left <= mX.right && right >= mX.left &&
+                       top <= mX.bottom && bottom >= mX.top;
+            }
+
+            inline static TreeBounds merge(
+                const TreeBounds& mA, const TreeBounds& mB) noexcept
+            {
+                TreeBounds result;
+                result.left = std::min(mA.left, mB.left);
+                result.right = std::max(mA.right, mB.right);
+                result.top = std::min(mA.top, mB.top);
+                result.bottom = std::max(mA.bottom, mB.bottom);
+                return result;
+            }
+        };
+    }
+
+    // Dynamic bounding volume hierarchy: every body is a leaf, internal
+    // nodes bound their two children. A body of any size is stored once,
+    // so huge statics cost as much as small movers.
+    // Leaves of moving bodies are fattened by a margin: as long as the
+    // body stays inside its fat bounds the tree is not touched. Insertion
+    // picks the sibling with the cheapest perimeter growth, and AVL-like
+    // rotations keep the tree balanced.
+    template <typename TW>
+    class DynamicTree
+    {
+    public:
+        using BaseType = Base<TW>;
+        using BodyType = Body<TW>;
+        using SpatialInfoType = DynamicTreeInfo<TW>;
+        using Bounds = Impl::TreeBounds;
+
+    private:
+        // 32-bit links keep nodes small, traversals are bound by memory.
+        using NodeId = std::uint32_t;
+        static constexpr NodeId nullNode{ssvu::NumLimits<NodeId>::max()};
+
+        // The traversal stack lives on the call stack: the tree is kept
+        // balanced, so its height stays well below this.
+        static constexpr SizeT maxStackSize{256};
+        static constexpr int displacementMultiplier{2};
+
+        struct Node
+        {
+            Bounds bounds;
+            BaseType* base{nullptr};
+            NodeId parent{nullNode}, child1{nullNode}, child2{nullNode};
+            int height{0};
+            Impl::ProxyKind kind;
+
+            inline bool isLeaf() const noexcept { return child1 == nullNode; }
+        };
+
+        // Statics get a tree of their own: huge platforms would otherwise
+        // bloat the nodes every moving body has to descend through.
+        std::vector<Node> nodes;
+        NodeId roots[2]{nullNode, nullNode};
+        NodeId freeList{nullNode};
+        int margin;
+
+        inline NodeId& getRoot(Impl::ProxyKind mKind) noexcept
+        {
+            return roots[mKind == Impl::ProxyKind::Static ? 1 : 0];
+        }
+
+        // Statics never move, fattening them would only add false
+        // positives.
+        inline int getMargin(Impl::ProxyKind mKind) const noexcept
+        {
+            return mKind == Impl::ProxyKind::Static ? 0 : margin;
+        }
+
+        inline NodeId allocateNode()
+        {
+            if(freeList == nullNode)
+            {
+                nodes.emplace_back();
+                return NodeId(nodes.size() - 1);
+            }
+
+            const auto id(freeList);
+            freeList = nodes[id].parent;
+            nodes[id] = Node{};
+            return id;
+        }
+        inline void freeNode(NodeId mId) noexcept
+        {
+            nodes[mId].base = nullptr;
+            nodes[mId].height = -1;
+            nodes[mId].parent = freeList;
+            freeList = mId;
+        }
+
+        inline void fixUpwards(NodeId mId)
+        {
+            for(; mId != nullNode; mId = nodes[mId].parent)
+            {
+                mId = balance(mId);
+
+                auto& n(nodes[mId]);
+                const auto& c1(nodes[n.child1]);
+                const auto& c2(nodes[n.child2]);
+                n.height = 1 + std::max(c1.height, c2.height);
+                n.bounds = Bounds::merge(c1.bounds, c2.bounds);
+            }
+        }
+
+        inline std::int64_t getDescentCost(
+            NodeId mChild, const Bounds& mLeaf) const noexcept
+        {
+            const auto& c(nodes[mChild]);
+            const auto merged(Bounds::merge(mLeaf, c.bounds).getPerimeter());
+            return c.isLeaf() ? merged : merged - c.bounds.getPerimeter();
+        }
+
+        inline void insertLeaf(NodeId mLeaf)
+        {
+            auto& root(getRoot(nodes[mLeaf].kind));
+            if(root == nullNode)
+            {
+                root = mLeaf;
+                nodes[root].parent = nullNode;
+                return;
+            }
+
+            // Walk down towards the sibling that makes the tree grow the
+            // least.
+            const auto leafBounds(nodes[mLeaf].bounds);
+            auto id(root);
+
+            while(!nodes[id].isLeaf())
+            {
+                const auto& n(nodes[id]);
+                const auto perimeter(n.bounds.getPerimeter());
+                const auto merged(
+                    Bounds::merge(n.bounds, leafBounds).getPerimeter());
+
+                // Cost of a new parent for `n` and the leaf, and minimum
+                // cost of pushing the leaf further down.
+                const auto cost(2 * merged);
+                const auto inheritance(2 * (merged - perimeter));
+                const auto cost1(
+                    getDescentCost(n.child1, leafBounds) + inheritance);
+                const auto cost2(
+                    getDescentCost(n.child2, leafBounds) + inheritance);
+
+                if(cost < cost1 && cost < cost2) break;
+                id = cost1 < cost2 ? n.child1 : n.child2;
+            }
+
+            const auto sibling(id);
+            const auto oldParent(nodes[sibling].parent);
+            const auto newParent(allocateNode());
+
+            auto& p(nodes[newParent]);
+            p.kind = nodes[mLeaf].kind;
+            p.parent = oldParent;
+            p.bounds = Bounds::merge(leafBounds, nodes[sibling].bounds);
+            p.height = nodes[sibling].height + 1;
+            p.child1 = sibling;
+            p.child2 = mLeaf;
+            nodes[sibling].parent = newParent;
+            nodes[mLeaf].parent = newParent;
+
+            if(oldParent == nullNode)
+                root = newParent;
+            else if(nodes[oldParent].child1 == sibling)
+                nodes[oldParent].child1 = newParent;
+            else
+                nodes[oldParent].child2 = newParent;
+
+            fixUpwards(oldParent);
+        }
+
+        inline void removeLeaf(NodeId mLeaf)
+        {
+            auto& root(getRoot(nodes[mLeaf].kind));
+            if(mLeaf == root)
+            {
+                root = nullNode;
+                return;
+            }
+
+            const auto parent(nodes[mLeaf].parent);
+            const auto grandParent(nodes[parent].parent);
+            const auto sibling(nodes[parent].child1 == mLeaf
+                                   ? nodes[parent].child2
+                                   : nodes[parent].child1);
+
+            nodes[sibling].parent = grandParent;
+            freeNode(parent);
+
+            if(grandParent == nullNode)
+            {
+                root = sibling;
+                return;
+            }
+
+            if(nodes[grandParent].child1 == parent)
+                nodes[grandParent].child1 = sibling;
+            else
+                nodes[grandParent].child2 = sibling;
+
+            fixUpwards(grandParent);
+        }
+
+        // Promotes the child `mUp` of `mA` in place of `mA`, if `mA` is
+        // unbalanced. Returns the node now at the position of `mA`.
+        inline NodeId rotate(NodeId mA, NodeId mUp, NodeId mOther)
+        {
+            auto& a(nodes[mA]);
+            auto& up(nodes[mUp]);
+            const auto f(up.child1), g(up.child2);
+
+            // `mUp` takes the place of `mA`.
+            up.child1 = mA;
+            up.parent = a.parent;
+            a.parent = mUp;
+
+            if(up.parent == nullNode)
+                getRoot(a.kind) = mUp;
+            else if(nodes[up.parent].child1 == mA)
+                nodes[up.parent].child1 = mUp;
+            else
+                nodes[up.parent].child2 = mUp;
+
+            // The taller grandchild stays with `mUp`, the other one
+            // replaces `mUp` under `mA`.
+            const bool keepF(nodes[f].height > nodes[g].height);
+            const auto kept(keepF ? f : g), moved(keepF ? g : f);
+
+            up.child2 = kept;
+            if(a.child1 == mUp)
+                a.child1 = moved;
+            else
+                a.child2 = moved;
+            nodes[moved].parent = mA;
+
+            a.bounds =
+                Bounds::merge(nodes[mOther].bounds, nodes[moved].bounds);
+            up.bounds = Bounds::merge(a.bounds, nodes[kept].bounds);
+            a.height =
+                1 + std::max(nodes[mOther].height, nodes[moved].height);
+            up.height = 1 + std::max(a.height, nodes[kept].height);
+
+            return mUp;
+        }
+        inline NodeId balance(NodeId mA)
+        {
+            const auto& a(nodes[mA]);
+            if(a.isLeaf() || a.height < 2) return mA;
+
+            const auto b(a.child1), c(a.child2);
+            const int diff{nodes[c].height - nodes[b].height};
+
+            if(diff > 1) return rotate(mA, c, b);
+            if(diff < -1) return rotate(mA, b, c);
+            return mA;
+        }
+
+        inline BodyType* getBody(const Node& mNode) const noexcept
+        {
+            SSVU_ASSERT(mNode.kind != Impl::ProxyKind::Sensor);
+            return &ssvu::castUp<BodyType>(*mNode.base);
+        }
+
+        // Depth-first traversal: subtrees rejected by `mVisit` are skipped,
+        // `mLeaf` is called for every accepted leaf.
+        template <typename TVisit, typename TLeaf>
+        inline void traverse(const TVisit& mVisit, const TLeaf& mLeaf) const
+        {
+            NodeId stack[maxStackSize];
+            SizeT size{0};
+            for(const auto& r : roots)
+                if(r != nullNode && mVisit(nodes[r].bounds)) stack[size++] = r;
+
+            // Children are tested before being pushed: rejected nodes never
+            // touch the stack.
+            while(size > 0)
+            {
+                const auto& n(nodes[stack[--size]]);
+                if(n.isLeaf())
+                {
+                    mLeaf(n);
+                    continue;
+                }
+
+                SSVU_ASSERT(size + 2 <= maxStackSize);
+                if(mVisit(nodes[n.child1].bounds)) stack[size++] = n.child1;
+                if(mVisit(nodes[n.child2].bounds)) stack[size++] = n.child2;
+            }
+        }
+
+    public:
+        // `mMargin` is how far a moving body can travel before its leaf
+        // has to be reinserted.
+        inline DynamicTree(int mMargin = 200) noexcept : margin{mMargin} {}
+
+        inline void setThreadCount(SizeT) noexcept {}
+        inline void refresh() noexcept {}
+
+        inline SizeT insert(
+            BaseType* mBase, const AABB& mShape, Impl::ProxyKind mKind)
+        {
+            return insert(mBase, Bounds{mShape, getMargin(mKind)}, mKind);
+        }
+        // Inserts with already fattened bounds.
+        inline SizeT insert(
+            BaseType* mBase, const Bounds& mBounds, Impl::ProxyKind mKind)
+        {
+            const auto id(allocateNode());
+            auto& n(nodes[id]);
+            n.base = mBase;
+            n.kind = mKind;
+            n.bounds = mBounds;
+
+            insertLeaf(id);
+            return id;
+        }
+        // Returns false if the shape still fits in the fat bounds. The new
+        // fat bounds are also stretched along `mDisplacement`, the last
+        // movement of the body, to predict where it is going.
+        inline bool move(
+            SizeT mId, const AABB& mShape, const Vec2i& mDisplacement)
+        {
+            auto& n(nodes[mId]);
+            if(n.bounds.contains(Bounds{mShape})) return false;
+
+            removeLeaf(mId);
+
+            n.bounds = Bounds{mShape, getMargin(n.kind)};
+            const auto d(mDisplacement * displacementMultiplier);
+            (d.x < 0 ? n.bounds.left : n.bounds.right) += d.x;
+            (d.y < 0 ? n.bounds.top : n.bounds.bottom) += d.y;
+
+            insertLeaf(mId);
+            return true;
+        }
+        inline void remove(SizeT mId)
+        {
+            removeLeaf(mId);
+            freeNode(mId);
+        }
+
+        inline const Bounds& getFatBounds(SizeT mId) const noexcept
+        {
+            return nodes[mId].bounds;
+        }
+        inline void setFatBounds(SizeT mId, const Bounds& mBounds)
+        {
+            auto& n(nodes[mId]);
+            if(n.bounds.contains(mBounds) && mBounds.contains(n.bounds))
+                return;
+
+            removeLeaf(mId);
+            n.bounds = mBounds;
+            insertLeaf(mId);
+        }
+
+        inline int getHeight() const noexcept
+        {
+            int result{0};
+            for(const auto& r : roots)
+                if(r != nullNode) result = std::max(result, nodes[r].height);
+            return result;
+        }
+
+        // Fat bounds of everything in the tree.
+        inline AABB getBounds() const noexcept
+        {
+            const auto dynamicRoot(roots[0]), staticRoot(roots[1]);
+            if(dynamicRoot == nullNode && staticRoot == nullNode)
+                return AABB{};
+
+            const auto b(dynamicRoot == nullNode
+                             ? nodes[staticRoot].bounds
+                             : staticRoot == nullNode
+                                   ? nodes[dynamicRoot].bounds
+                                   : Bounds::merge(nodes[dynamicRoot].bounds,
+                                         nodes[staticRoot].bounds));
+            return AABB{b.left, b.right, b.top, b.bottom};
+        }
+
+        // Calls `mF` for every body whose bounds overlap `mArea`.
+        template <typename TF>
+        inline void forEachInBounds(const AABB& mArea, const TF& mF) const
+        {
+            const Bounds area{mArea};
+
+            traverse(
+                [&area](const Bounds& mB)
+                {
+                    return mB.isOverlapping(area);
+                },
+                [this, &area, &mF](const Node& mNode)
+                {
+                    if(mNode.kind == Impl::ProxyKind::Sensor) return;
+
+                    auto* body(getBody(mNode));
+                    if(Bounds{body->getShape()}.isOverlapping(area)) mF(body);
+                });
+        }
+
+        // Calls `mF` for every body crossed by the segment from `mStart` to
+        // `mEnd`.
+        template <typename TF>
+        inline void forEachOnSegment(
+            const Vec2f& mStart, const Vec2f& mEnd, const TF& mF) const
+        {
+            const auto delta(mEnd - mStart);
+            float t;
+
+            traverse(
+                [&](const Bounds& mB)
+                {
+                    return Utils::isSegmentOverlapping(mB, mStart, delta, t);
+                },
+                [&](const Node& mNode)
+                {
+                    if(mNode.kind == Impl::ProxyKind::Sensor) return;
+
+                    auto* body(getBody(mNode));
+                    if(Utils::isSegmentOverlapping(
+                           body->getShape(), mStart, delta, t))
+                        mF(body);
+                });
+        }
+    };
+
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::Point>
+    {
+        using Type = BoundsQueryTypes::Point<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::Distance>
+    {
+        using Type = BoundsQueryTypes::Distance<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::RayCast>
+    {
+        using Type = BoundsQueryTypes::RayCast<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::OrthoLeft>
+    {
+        using Type = BoundsQueryTypes::OrthoLeft<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::OrthoRight>
+    {
+        using Type = BoundsQueryTypes::OrthoRight<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::OrthoUp>
+    {
+        using Type = BoundsQueryTypes::OrthoUp<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::OrthoDown>
+    {
+        using Type = BoundsQueryTypes::OrthoDown<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::Area>
+    {
+        using Type = BoundsQueryTypes::Area<TW, DynamicTree<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, DynamicTree<TW>, QueryType::Nearest>
+    {
+        using Type = BoundsQueryTypes::Nearest<TW, DynamicTree<TW>>;
+    };
+
+    template <typename TW>
+    struct QueryModeDispatcher<TW, DynamicTree<TW>, QueryMode::All>
+    {
+        using Type = BoundsQueryTypes::Bodies::All<TW>;
+    };
+    template <typename TW>
+    struct QueryModeDispatcher<TW, DynamicTree<TW>, QueryMode::ByGroup>
+    {
+        using Type = BoundsQueryTypes::Bodies::ByGroup<TW>;
+    };
+}
+
+#endif
@@ -0,0 +1,179 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_DYNAMICTREEINFO
+#define SSVSC_SPATIAL_DYNAMICTREEINFO
+
+namespace ssvsc
+{
+    template <typename TW>
+    class DynamicTreeInfo
+    {
+    public:
+        using SpatialType = typename TW::SpatialType;
+        using BaseType = Base<TW>;
+        using BodyType = Body<TW>;
+        using SensorType = Sensor<TW>;
+        using BoundsType = typename SpatialType::Bounds;
+
+        // The fat bounds depend on the past movement: they are saved as
+        // they are, not recomputed from the shape.
+        struct State
+        {
+            BoundsType bounds;
+            Impl::ProxyKind kind;
+            bool inserted, invalid;
+        };
+
+    private:
+        SpatialType& tree;
+        BaseType& base;
+        SizeT proxy{0};
+        Impl::ProxyKind kind;
+        bool inserted{false}, invalid{true};
+
+        inline const AABB& getShapeImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).getShape();
+        }
+        inline const AABB& getShapeImpl(SensorTag) const noexcept
+        {
+            return ssvu::castUp<SensorType>(base).getShape();
+        }
+        inline Vec2i getDisplacementImpl(BodyTag) const noexcept
+        {
+            const auto& body(ssvu::castUp<BodyType>(base));
+            return body.getPosition() - body.getOldPosition();
+        }
+        inline Vec2i getDisplacementImpl(SensorTag) const noexcept
+        {
+            return {0, 0};
+        }
+        inline Impl::ProxyKind getKindImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).isStatic()
+                       ? Impl::ProxyKind::Static
+                       : Impl::ProxyKind::Body;
+        }
+        inline Impl::ProxyKind getKindImpl(SensorTag) const noexcept
+        {
+            return Impl::ProxyKind::Sensor;
+        }
+        inline void handleCollisionImpl(FT mFT, BodyType* mBody, BodyTag) const
+            noexcept
+        {
+            SSVU_ASSERT(mBody != nullptr);
+            ssvu::castUp<BodyType>(base).handleCollision(mFT, mBody);
+        }
+        inline void handleCollisionImpl(
+            FT mFT, BodyType* mBody, SensorTag) const noexcept
+        {
+            SSVU_ASSERT(mBody != nullptr);
+            ssvu::castUp<SensorType>(base).handleCollision(mFT, mBody);
+        }
+
+    public:
+        inline DynamicTreeInfo(SpatialType& mTree, BaseType& mBase) noexcept
+            : tree(mTree),
+              base(mBase)
+        {
+        }
+
+        template <typename TTag>
+        inline void init()
+        {
+            destroy<TTag>();
+
+            kind = getKindImpl(TTag{});
+            proxy = tree.insert(&base, getShapeImpl(TTag{}), kind);
+            inserted = true;
+            invalid = false;
+        }
+        inline void invalidate() noexcept { invalid = true; }
+        template <typename TTag>
+        inline void preUpdate()
+        {
+            if(!invalid) return;
+
+            // Statics and dynamic bodies are not fattened the same way.
+            if(!inserted || kind != getKindImpl(TTag{}))
+            {
+                init<TTag>();
+                return;
+            }
+
+            tree.move(
+                proxy, getShapeImpl(TTag{}), getDisplacementImpl(TTag{}));
+            invalid = false;
+        }
+        inline void postUpdate() const noexcept {}
+        inline void refreshGroups() const noexcept {}
+
+        inline State getState() const noexcept
+        {
+            State result{};
+            result.inserted = inserted;
+            result.invalid = invalid;
+            if(!inserted) return result;
+
+            result.bounds = tree.getFatBounds(proxy);
+            result.kind = kind;
+            return result;
+        }
+        template <typename TTag>
+        inline void setState(const State& mState)
+        {
+            invalid = mState.invalid;
+
+            if(!mState.inserted)
+            {
+                destroy<TTag>();
+                return;
+            }
+
+            if(!inserted || kind != mState.kind)
+            {
+                destroy<TTag>();
+
+                kind = mState.kind;
+                proxy = tree.insert(&base, mState.bounds, kind);
+                inserted = true;
+                return;
+            }
+
+            tree.setFatBounds(proxy, mState.bounds);
+        }
+        template <typename TTag>
+        inline void destroy()
+        {
+            if(!inserted) return;
+
+            tree.remove(proxy);
+            inserted = false;
+        }
+
+        // Every leaf is visited at most once, no deduplication needed.
+        template <typename TTag, typename TF>
+        inline void forEachCandidate(SizeT, const TF& mF) const
+        {
+            if(!inserted) return;
+
+            tree.forEachInBounds(getShapeImpl(TTag{}), [this, &mF](
+                                                          BodyType* mBody)
+                {
+                    if(mBody != &base) mF(mBody);
+                });
+        }
+        template <typename TTag>
+        inline void handleCollisions(FT mFT)
+        {
+            forEachCandidate<TTag>(0, [this, mFT](BodyType* mBody)
+                {
+                    handleCollisionImpl(mFT, mBody, TTag{});
+                });
+        }
+    };
+}
+
+#endif
@@ -7,31 +7,167 @@
 
 namespace ssvsc
 {
+    namespace Impl
+    {
+        // Position of a body in a cell: its layer and its index there.
+        struct CellIdx
+        {
+            SizeT idx{0};
+            bool isStatic{false};
+        };
+
+        // A cell holding a body, and the position of the body in that cell.
+        template <typename TCell>
+        struct CellMembership
+        {
+            TCell* cell;
+            CellIdx idx;
+
+            inline CellMembership(TCell* mCell) noexcept : cell{mCell} {}
+        };
+    }
+
+    // Static and dynamic bodies are kept in separate lists, so that
+    // callers can skip one of them. The cell also keeps a superset of the
+    // groups of its bodies, so that callers can skip it when they look
+    // for other groups. Groups of bodies that left or changed groups stay
+    // in it until as many changes as members piled up: recomputing it is
+    // amortized over them, and removals stay O(1).
+    // Bodies are removed in O(1) by swapping with the last one. The owner
+    // of each membership keeps the index of its body, and the cell keeps a
+    // pointer to that index to fix it when the body is moved.
     template <typename TW>
     class Cell
     {
     public:
         using BaseType = Base<TW>;
         using BodyType = Body<TW>;
+        using GroupBitsetType = typename TW::GroupBitsetType;
 
     private:
-        std::vector<BodyType*> bodies;
+        struct Layer
+        {
+            std::vector<BodyType*> bodies;
+            std::vector<Impl::CellIdx*> idxRefs;
+        };
+
+        Layer statics, dynamics;
+        GroupBitsetType groups;
+        SizeT groupChanges{0};
+
+        inline Layer& getLayer(bool mStatic) noexcept
+        {
+            return mStatic ? statics : dynamics;
+        }
+
+        inline void addGroupChange() noexcept
+        {
+            if(++groupChanges >= getSize()) refreshGroups();
+        }
 
     public:
-        inline void add(BaseType* mBase, BodyTag)
+        // The layer is chosen by the current static flag of the body.
+        inline void add(BaseType* mBase, Impl::CellIdx& mIdx, BodyTag)
         {
             SSVU_ASSERT(mBase != nullptr);
-            bodies.emplace_back(ssvu::castUp<BodyType>(mBase));
+            auto* body(ssvu::castUp<BodyType>(mBase));
+            auto& l(getLayer(body->isStatic()));
+
+            mIdx.idx = l.bodies.size();
+            mIdx.isStatic = body->isStatic();
+            l.bodies.emplace_back(body);
+            l.idxRefs.emplace_back(&mIdx);
+            groups |= body->getGroups();
         }
-        inline void del(BaseType* mBase, BodyTag)
+        inline void del(const Impl::CellIdx& mIdx, BodyTag)
         {
-            SSVU_ASSERT(mBase != nullptr);
-            ssvu::eraseRemove(bodies, ssvu::castUp<BodyType>(mBase));
+            auto& l(getLayer(mIdx.isStatic));
+            const SizeT i{mIdx.idx};
+
+            SSVU_ASSERT(i < l.bodies.size());
+            l.bodies[i] = l.bodies.back();
+            l.idxRefs[i] = l.idxRefs.back();
+            l.idxRefs[i]->idx = i;
+            l.bodies.pop_back();
+            l.idxRefs.pop_back();
+            addGroupChange();
         }
-        inline void add(BaseType*, SensorTag) {}
-        inline void del(BaseType*, SensorTag) {}
+        // The position of its body is now stored in `mIdx` itself.
+        inline void relink(Impl::CellIdx& mIdx, BodyTag) noexcept
+        {
+            auto& l(getLayer(mIdx.isStatic));
+            SSVU_ASSERT(mIdx.idx < l.idxRefs.size());
+            l.idxRefs[mIdx.idx] = &mIdx;
+        }
+        inline void add(BaseType*, Impl::CellIdx&, SensorTag) {}
+        inline void del(const Impl::CellIdx&, SensorTag) {}
+        inline void relink(Impl::CellIdx&, SensorTag) noexcept {}
 
-        inline const auto& getBodies() const noexcept { return bodies; }
+        // Recomputes the groups of the members.
+        inline void refreshGroups() noexcept
+        {
+            groups.reset();
+            groupChanges = 0;
+            forEachBody([this](const BodyType* mBody)
+                {
+                    groups |= mBody->getGroups();
+                });
+        }
+        // A member now has `mGroups`, and may have lost others.
+        inline void changeGroups(const GroupBitsetType& mGroups) noexcept
+        {
+            groups |= mGroups;
+            addGroupChange();
+        }
+
+        inline bool hasGroup(Group mGroup) const noexcept
+        {
+            return groups[mGroup];
+        }
+        inline bool hasAnyGroup(const GroupBitsetType& mGroups) const
+            noexcept
+        {
+            return (groups & mGroups).any();
+        }
+        inline const auto& getGroups() const noexcept { return groups; }
+
+        inline SizeT getSize() const noexcept
+        {
+            return statics.bodies.size() + dynamics.bodies.size();
+        }
+        inline const auto& getStatics() const noexcept
+        {
+            return statics.bodies;
+        }
+        inline const auto& getDynamics() const noexcept
+        {
+            return dynamics.bodies;
+        }
+        // Whether a dynamic body other than `mBase` is here.
+        inline bool hasDynamicBesides(const BaseType* mBase) const noexcept
+        {
+            const auto& d(dynamics.bodies);
+            return d.size() > 1 || (d.size() == 1 && d[0] != mBase);
+        }
+
+        // Calls `mF` on the statics, then on the dynamic bodies.
+        template <typename TF>
+        inline void forEachBody(const TF& mF) const
+        {
+            for(const auto& b : statics.bodies) mF(b);
+            for(const auto& b : dynamics.bodies) mF(b);
+        }
+        // Like `forEachBody`, only for the bodies in `mGroup`.
+        template <typename TF>
+        inline void forEachBodyInGroup(Group mGroup, const TF& mF) const
+        {
+            if(!hasGroup(mGroup)) return;
+
+            forEachBody([mGroup, &mF](BodyType* mBody)
+                {
+                    if(mBody->hasGroup(mGroup)) mF(mBody);
+                });
+        }
     };
 }
 
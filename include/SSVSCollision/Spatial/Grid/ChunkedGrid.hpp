@@ -0,0 +1,253 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_GRID_CHUNKEDGRID
+#define SSVSC_SPATIAL_GRID_CHUNKEDGRID
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Cell that keeps the member count of its chunk up to date, so that
+        // empty chunks can be found without scanning them.
+        template <typename TW>
+        class ChunkCell : public Cell<TW>
+        {
+        private:
+            SizeT* population{nullptr};
+
+        public:
+            inline void setPopulation(SizeT* mPopulation) noexcept
+            {
+                population = mPopulation;
+            }
+
+            template <typename TTag>
+            inline void add(Base<TW>* mBase, CellIdx& mIdx, TTag mTag)
+            {
+                Cell<TW>::add(mBase, mIdx, mTag);
+                ++*population;
+            }
+            template <typename TTag>
+            inline void del(const CellIdx& mIdx, TTag mTag)
+            {
+                Cell<TW>::del(mIdx, mTag);
+                SSVU_ASSERT(*population > 0);
+                --*population;
+            }
+        };
+    }
+
+    // Unbounded grid: cells are allocated in square chunks on first touch,
+    // and chunks that stay empty for a number of frames are freed. Memory
+    // is proportional to the occupied area and bodies never go out of
+    // bounds.
+    // Queries only see the area covered by allocated chunks.
+    template <typename TW>
+    class ChunkedGrid
+    {
+    public:
+        using CellType = Impl::ChunkCell<TW>;
+        using SpatialInfoType = GridInfo<TW>;
+
+        static constexpr int chunkSide{32};
+
+    private:
+        struct Chunk
+        {
+            std::vector<CellType> cells;
+            SizeT population{0}, emptyFrames{0};
+
+            inline Chunk() : cells(chunkSide * chunkSide)
+            {
+                for(auto& c : cells) c.setPopulation(&population);
+            }
+        };
+
+        // Chunk coordinates packed in 64 bits, mixed before bucketing.
+        struct ChunkHash
+        {
+            inline SizeT operator()(std::uint64_t mKey) const noexcept
+            {
+                mKey ^= mKey >> 33;
+                mKey *= 0xff51afd7ed558ccdull;
+                mKey ^= mKey >> 33;
+                return SizeT(mKey);
+            }
+        };
+
+        std::unordered_map<std::uint64_t, UPtr<Chunk>, ChunkHash> chunks;
+        std::vector<Impl::PaintContext> paints{1};
+        const CellType emptyCell{};
+        int cellSize;
+        SizeT reclaimFrames;
+
+        // Cell bounds of the allocated chunks, `max` excluded.
+        Vec2i idxMin{0, 0}, idxMax{0, 0};
+
+        // Last chunk returned by `getCell(int, int)`: bodies touch a few
+        // neighbouring cells in a row.
+        Chunk* lastChunk{nullptr};
+        Vec2i lastChunkIdx;
+
+        inline static std::uint64_t getKey(int mX, int mY) noexcept
+        {
+            return (std::uint64_t(std::uint32_t(mX)) << 32) |
+                   std::uint32_t(mY);
+        }
+        inline static int getCellIdxInChunk(int mX, int mY) noexcept
+        {
+            const int x{mX - Impl::floorDiv(mX, chunkSide) * chunkSide};
+            const int y{mY - Impl::floorDiv(mY, chunkSide) * chunkSide};
+            return ssvu::get1DIdxFrom2D(x, y, chunkSide);
+        }
+
+        inline void recalcBounds() noexcept
+        {
+            if(chunks.empty())
+            {
+                idxMin = idxMax = Vec2i{0, 0};
+                return;
+            }
+
+            idxMin = Vec2i{ssvu::NumLimits<int>::max(),
+                ssvu::NumLimits<int>::max()};
+            idxMax = Vec2i{ssvu::NumLimits<int>::min(),
+                ssvu::NumLimits<int>::min()};
+
+            for(const auto& p : chunks)
+            {
+                const int x{int(std::uint32_t(p.first >> 32))};
+                const int y{int(std::uint32_t(p.first))};
+                idxMin.x = std::min(idxMin.x, x * chunkSide);
+                idxMin.y = std::min(idxMin.y, y * chunkSide);
+                idxMax.x = std::max(idxMax.x, (x + 1) * chunkSide);
+                idxMax.y = std::max(idxMax.y, (y + 1) * chunkSide);
+            }
+        }
+
+        inline const Chunk* findChunk(int mX, int mY) const
+        {
+            const auto itr(chunks.find(getKey(Impl::floorDiv(mX, chunkSide),
+                Impl::floorDiv(mY, chunkSide))));
+            return itr == std::end(chunks) ? nullptr : itr->second.get();
+        }
+
+    public:
+        // Chunks empty for `mReclaimFrames` consecutive frames are freed.
+        inline ChunkedGrid(int mCellSize, SizeT mReclaimFrames = 60)
+            : cellSize{mCellSize}, reclaimFrames{mReclaimFrames}
+        {
+            SSVU_ASSERT(cellSize > 0);
+        }
+
+        inline int getIdxXMin() const noexcept { return idxMin.x; }
+        inline int getIdxYMin() const noexcept { return idxMin.y; }
+        inline int getIdxXMax() const noexcept { return idxMax.x; }
+        inline int getIdxYMax() const noexcept { return idxMax.y; }
+        inline int getCellSize() const noexcept { return cellSize; }
+        inline SizeT getChunkCount() const noexcept { return chunks.size(); }
+
+        inline void setThreadCount(SizeT mCount)
+        {
+            paints.resize(std::max(mCount, SizeT(1)));
+        }
+        inline auto& getPaint(SizeT mThread) noexcept
+        {
+            SSVU_ASSERT(mThread < paints.size());
+            return paints[mThread];
+        }
+
+        // Ages the empty chunks and frees the old ones.
+        inline void refresh()
+        {
+            bool freed{false};
+
+            for(auto itr(std::begin(chunks)); itr != std::end(chunks);)
+            {
+                auto& c(*itr->second);
+                if(c.population > 0)
+                {
+                    c.emptyFrames = 0;
+                    ++itr;
+                    continue;
+                }
+
+                if(++c.emptyFrames < reclaimFrames)
+                {
+                    ++itr;
+                    continue;
+                }
+
+                itr = chunks.erase(itr);
+                freed = true;
+            }
+
+            if(!freed) return;
+
+            lastChunk = nullptr;
+            recalcBounds();
+        }
+
+        inline int getIdx(int mValue) const noexcept
+        {
+            return Impl::floorDiv(mValue, cellSize);
+        }
+        inline Vec2i getIdx(const Vec2i& mPos) const noexcept
+        {
+            return {getIdx(mPos.x), getIdx(mPos.y)};
+        }
+
+        // Allocates the chunk of the cell if needed.
+        inline CellType& getCell(int mX, int mY)
+        {
+            const Vec2i chunkIdx{Impl::floorDiv(mX, chunkSide),
+                Impl::floorDiv(mY, chunkSide)};
+
+            if(lastChunk == nullptr || lastChunkIdx != chunkIdx)
+            {
+                auto& c(chunks[getKey(chunkIdx.x, chunkIdx.y)]);
+                if(c == nullptr)
+                {
+                    c = std::make_unique<Chunk>();
+
+                    const bool first{chunks.size() == 1};
+                    const Vec2i min{chunkIdx * chunkSide};
+                    const Vec2i max{min + Vec2i{chunkSide, chunkSide}};
+                    idxMin.x = first ? min.x : std::min(idxMin.x, min.x);
+                    idxMin.y = first ? min.y : std::min(idxMin.y, min.y);
+                    idxMax.x = first ? max.x : std::max(idxMax.x, max.x);
+                    idxMax.y = first ? max.y : std::max(idxMax.y, max.y);
+                }
+
+                lastChunk = c.get();
+                lastChunkIdx = chunkIdx;
+            }
+
+            return lastChunk->cells[getCellIdxInChunk(mX, mY)];
+        }
+
+        // Never allocates: cells of missing chunks are empty.
+        inline const CellType& getCell(const Vec2i& mIdx) const
+        {
+            const auto* c(findChunk(mIdx.x, mIdx.y));
+            return c == nullptr ? emptyCell
+                                : c->cells[getCellIdxInChunk(mIdx.x, mIdx.y)];
+        }
+
+        // Cell indices are valid inside the allocated area, used by the
+        // queries to stop. Bodies are never out of bounds.
+        inline bool isIdxValid(const Vec2i& mIdx) const noexcept
+        {
+            return mIdx.x >= idxMin.x && mIdx.x < idxMax.x &&
+                   mIdx.y >= idxMin.y && mIdx.y < idxMax.y;
+        }
+        inline bool isIdxValid(int, int, int, int) const noexcept
+        {
+            return true;
+        }
+    };
+}
+
+#endif
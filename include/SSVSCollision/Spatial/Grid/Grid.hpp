@@ -15,6 +15,28 @@ namespace ssvsc
 
     namespace Impl
     {
+        // Floor division: cells and chunks must not be mirrored around 0.
+        inline int floorDiv(int mA, int mB) noexcept
+        {
+            SSVU_ASSERT(mB > 0);
+            return mA >= 0 ? mA / mB : -((-mA + mB - 1) / mB);
+        }
+
+        // Read-only cell lookup: `nullptr` if the cell was never touched.
+        template <typename TW>
+        inline const Cell<TW>* findCell(
+            const std::vector<Cell<TW>>& mCells, int mIdx)
+        {
+            return &mCells.at(mIdx);
+        }
+        template <typename TW, typename TH, typename TE>
+        inline const Cell<TW>* findCell(
+            const std::unordered_map<int, Cell<TW>, TH, TE>& mCells, int mIdx)
+        {
+            const auto itr(mCells.find(mIdx));
+            return itr == std::end(mCells) ? nullptr : &itr->second;
+        }
+
         template <typename TW, typename TC, typename TDerived>
         class GridBase
         {
@@ -24,7 +46,9 @@ namespace ssvsc
 
         protected:
             TC cells;
+            const CellType emptyCell{};
             int cols, rows, cellSize, offset;
+            std::vector<PaintContext> paints{1};
 
         public:
             inline GridBase(
@@ -42,27 +66,44 @@ namespace ssvsc
             inline int getOffset() const noexcept { return offset; }
             inline int getCellSize() const noexcept { return cellSize; }
 
+            // One paint context per thread that may walk the grid at once.
+            inline void setThreadCount(SizeT mCount)
+            {
+                paints.resize(std::max(mCount, SizeT(1)));
+            }
+            inline auto& getPaint(SizeT mThread) noexcept
+            {
+                SSVU_ASSERT(mThread < paints.size());
+                return paints[mThread];
+            }
+
+            // Called by `World::update` once per frame, before the bodies
+            // are updated.
+            inline void refresh() noexcept {}
+
             inline int getIdx(int mValue) const noexcept
             {
-                SSVU_ASSERT(cellSize != 0);
-                return mValue / cellSize;
+                return floorDiv(mValue, cellSize);
             }
             inline Vec2i getIdx(const Vec2i& mPos) const noexcept
             {
                 return {getIdx(mPos.x), getIdx(mPos.y)};
             }
 
-            inline const auto& getCell(int mX, int mY) const
+            // Never inserts: used by the queries, which may run on several
+            // threads at once.
+            inline const CellType& getCell(int mX, int mY) const
             {
-                return cells.at(
-                    ssvu::get1DIdxFrom2D(mX + offset, mY + offset, cols));
+                const auto* c(findCell(cells,
+                    ssvu::get1DIdxFrom2D(mX + offset, mY + offset, cols)));
+                return c == nullptr ? emptyCell : *c;
             }
             inline auto& getCell(int mX, int mY)
             {
                 return cells[ssvu::get1DIdxFrom2D(
                     mX + offset, mY + offset, cols)];
             }
-            inline const auto& getCell(const Vec2i& mIdx) const
+            inline const CellType& getCell(const Vec2i& mIdx) const
             {
                 return getCell(mIdx.x, mIdx.y);
             }
@@ -116,7 +157,7 @@ namespace ssvsc
             : Impl::GridBase<TW, Impl::GridType<TW>, Grid<TW>>{
                   mCols, mRows, mCellSize, mOffset}
         {
-            this->cells.reserve(this->cols * this->rows);
+            this->cells.resize(this->cols * this->rows);
         }
     };
 
@@ -147,6 +188,10 @@ namespace ssvsc
         struct OrthoUp;
         template <typename TW, typename TGrid>
         struct OrthoDown;
+        template <typename TW, typename TGrid>
+        struct Area;
+        template <typename TW, typename TGrid>
+        struct Nearest;
         namespace Bodies
         {
             template <typename TW>
@@ -191,6 +236,16 @@ namespace ssvsc
     {
         using Type = GridQueryTypes::OrthoDown<TW, TGrid>;
     };
+    template <typename TW, typename TGrid>
+    struct QueryTypeDispatcher<TW, TGrid, QueryType::Area>
+    {
+        using Type = GridQueryTypes::Area<TW, TGrid>;
+    };
+    template <typename TW, typename TGrid>
+    struct QueryTypeDispatcher<TW, TGrid, QueryType::Nearest>
+    {
+        using Type = GridQueryTypes::Nearest<TW, TGrid>;
+    };
 
     template <typename TW, typename TGrid>
     struct QueryModeDispatcher<TW, TGrid, QueryMode::All>
@@ -15,7 +15,15 @@ namespace ssvsc
         using BaseType = Base<TW>;
         using BodyType = Body<TW>;
         using SensorType = Sensor<TW>;
-        using CellType = Cell<TW>;
+        using CellType = typename SpatialType::CellType;
+
+        // What `setState` needs to rebuild the same cells.
+        struct State
+        {
+            int startX, startY, endX, endY;
+            int heldStartX, heldStartY, heldEndX, heldEndY;
+            bool inCells, invalid;
+        };
 
     private:
         SpatialType& grid;
@@ -23,10 +31,16 @@ namespace ssvsc
         // TODO: unnecessary if inheritance is used
         BaseType& base;
 
-        std::vector<CellType*> cells;
+        using MembershipType = Impl::CellMembership<CellType>;
+
+        // `cells` holds the rectangle `held*`, column by column.
+        // `nextCells` is reused to build the next one. Cells point to the
+        // memberships: the vectors must not reallocate once filled.
+        std::vector<MembershipType> cells, nextCells;
         int startX{0}, startY{0}, endX{0}, endY{0}, oldStartX{-1},
-            oldStartY{-1}, oldEndX{-1}, oldEndY{-1}, spatialPaint{-1};
-        bool invalid{true};
+            oldStartY{-1}, oldEndX{-1}, oldEndY{-1};
+        int heldStartX{0}, heldStartY{0}, heldEndX{-1}, heldEndY{-1};
+        bool heldStatic{false}, invalid{true};
 
         inline const AABB& getShapeImpl(BodyTag) const noexcept
         {
@@ -36,6 +50,11 @@ namespace ssvsc
         {
             return ssvu::castUp<SensorType>(base).getShape();
         }
+        inline bool isStaticImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).isStatic();
+        }
+        inline bool isStaticImpl(SensorTag) const noexcept { return false; }
         inline void handleCollisionImpl(FT mFT, BodyType* mBody, BodyTag) const
             noexcept
         {
@@ -64,45 +83,118 @@ namespace ssvsc
             endX = grid.getIdx(shape.getRight());
             endY = grid.getIdx(shape.getBottom());
 
+            // `setStatic` moves the body to the other layer of its cells.
             if(oldStartX != startX || oldStartY != startY || oldEndX != endX ||
-                oldEndY != endY)
+                oldEndY != endY || heldStatic != isStaticImpl(TTag{}))
                 calcCells<TTag>();
             else
                 invalid = false;
         }
+        inline bool isHeld(int mX, int mY) const noexcept
+        {
+            return mX >= heldStartX && mX <= heldEndX && mY >= heldStartY &&
+                   mY <= heldEndY;
+        }
+        inline bool isInEdges(int mX, int mY) const noexcept
+        {
+            return mX >= startX && mX <= endX && mY >= startY && mY <= endY;
+        }
         template <typename TTag>
-        inline void calcCells()
+        inline void setHeld() noexcept
         {
-            clear<TTag>();
+            heldStartX = startX;
+            heldStartY = startY;
+            heldEndX = endX;
+            heldEndY = endY;
+            heldStatic = isStaticImpl(TTag{});
+        }
 
+        template <typename TTag>
+        inline void calcCells()
+        {
             if(!grid.isIdxValid(startX, startY, endX, endY))
             {
+                clear<TTag>();
                 base.setOutOfBounds(true);
                 return;
             }
+
+            if(!cells.empty() && heldStatic == isStaticImpl(TTag{}))
+                diffCells<TTag>();
+            else
+            {
+                clear<TTag>();
+                addCells<TTag>();
+            }
+
+            setHeld<TTag>();
+            invalid = false;
+        }
+        inline SizeT getCellCount() const noexcept
+        {
+            return SizeT(endX - startX + 1) * SizeT(endY - startY + 1);
+        }
+
+        template <typename TTag>
+        inline void addCells()
+        {
+            cells.reserve(getCellCount());
             for(int iX{startX}; iX <= endX; ++iX)
                 for(int iY{startY}; iY <= endY; ++iY)
                 {
                     auto& c(grid.getCell(iX, iY));
                     cells.emplace_back(&c);
-                    c.add(&base, TTag{});
+                    c.add(&base, cells.back().idx, TTag{});
+                }
+        }
+        // Only the cells leaving and entering the rectangle are touched:
+        // the memberships of the cells in both are moved and relinked.
+        template <typename TTag>
+        inline void diffCells()
+        {
+            const int heldRows{heldEndY - heldStartY + 1};
+            const auto getHeld([this, heldRows](int mX, int mY) -> auto&
+                {
+                    return cells[(mX - heldStartX) * heldRows +
+                                 (mY - heldStartY)];
+                });
+
+            for(int iX{heldStartX}; iX <= heldEndX; ++iX)
+                for(int iY{heldStartY}; iY <= heldEndY; ++iY)
+                {
+                    if(isInEdges(iX, iY)) continue;
+
+                    const auto& m(getHeld(iX, iY));
+                    m.cell->del(m.idx, TTag{});
                 }
 
-            invalid = false;
+            nextCells.clear();
+            nextCells.reserve(getCellCount());
+            for(int iX{startX}; iX <= endX; ++iX)
+                for(int iY{startY}; iY <= endY; ++iY)
+                {
+                    if(isHeld(iX, iY))
+                    {
+                        nextCells.emplace_back(getHeld(iX, iY));
+                        auto& m(nextCells.back());
+                        m.cell->relink(m.idx, TTag{});
+                        continue;
+                    }
+
+                    auto& c(grid.getCell(iX, iY));
+                    nextCells.emplace_back(&c);
+                    c.add(&base, nextCells.back().idx, TTag{});
+                }
+
+            std::swap(cells, nextCells);
         }
         template <typename TTag>
         inline void clear()
         {
-            for(const auto& c : cells) c->del(&base, TTag{});
+            for(const auto& m : cells) m.cell->del(m.idx, TTag{});
             cells.clear();
         }
 
-        inline auto& getLastPaint() const noexcept
-        {
-            static int lastPaint{0};
-            return lastPaint;
-        }
-
     public:
         inline GridInfo(SpatialType& mGrid, BaseType& mBase) noexcept
             : grid(mGrid),
@@ -128,19 +220,101 @@ namespace ssvsc
         {
             clear<TTag>();
         }
+        inline void refreshGroups() noexcept
+        {
+            for(const auto& m : cells) m.cell->changeGroups(base.getGroups());
+        }
+
+        // Top-left cell holding the body. It lags the shape until the next
+        // `preUpdate`.
+        inline Vec2i getFirstCell() const noexcept
+        {
+            return {heldStartX, heldStartY};
+        }
+
+        inline State getState() const noexcept
+        {
+            return {startX, startY, endX, endY, heldStartX, heldStartY,
+                heldEndX, heldEndY, !cells.empty(), invalid};
+        }
+        // Only touches the cells if the held rectangle or layer changed.
+        template <typename TTag>
+        inline void setState(const State& mState)
+        {
+            if(!mState.inCells)
+                clear<TTag>();
+            else if(cells.empty() || heldStartX != mState.heldStartX ||
+                    heldStartY != mState.heldStartY ||
+                    heldEndX != mState.heldEndX ||
+                    heldEndY != mState.heldEndY ||
+                    heldStatic != isStaticImpl(TTag{}))
+            {
+                startX = mState.heldStartX;
+                startY = mState.heldStartY;
+                endX = mState.heldEndX;
+                endY = mState.heldEndY;
+                calcCells<TTag>();
+            }
+
+            startX = mState.startX;
+            startY = mState.startY;
+            endX = mState.endX;
+            endY = mState.endY;
+            heldStartX = mState.heldStartX;
+            heldStartY = mState.heldStartY;
+            heldEndX = mState.heldEndX;
+            heldEndY = mState.heldEndY;
+            invalid = mState.invalid;
+        }
+        // Calls `mF` once for every body sharing a cell with this one.
+        // Bodies are deduplicated with the grid's paint context for
+        // `mThread`: concurrent calls must use different thread indices.
+        template <typename TTag, typename TF>
+        inline void forEachCandidate(SizeT mThread, const TF& mF) const
+        {
+            forEachCandidateIn(mThread, [](const CellType&)
+                {
+                    return true;
+                },
+                mF);
+        }
+        // Like `forEachCandidate`, skipping the cells rejected by
+        // `mCellPred`.
+        template <typename TCellPred, typename TF>
+        inline void forEachCandidateIn(
+            SizeT mThread, const TCellPred& mCellPred, const TF& mF) const
+        {
+            auto& paint(grid.getPaint(mThread));
+            paint.begin();
+
+            for(const auto& m : cells)
+            {
+                if(!mCellPred(*m.cell)) continue;
+
+                m.cell->forEachBody([&paint, &mF](BodyType* mBody)
+                    {
+                        if(paint.paint(mBody->getSlot())) mF(mBody);
+                    });
+            }
+        }
+        // Cells without a group to check hold nothing to handle, unless
+        // another dynamic body there may check this one: a pair is only
+        // handled by one of its bodies, see `Body::handleCollision`.
         template <typename TTag>
         inline void handleCollisions(FT mFT)
         {
-            ++(getLastPaint());
+            const auto& toCheck(base.getGroupsToCheck());
+            constexpr bool checked{std::is_same<TTag, BodyTag>{}};
 
-            for(const auto& c : cells)
-                for(const auto& b : c->getBodies())
+            forEachCandidateIn(0, [this, &toCheck](const CellType& mCell)
                 {
-                    if(b->getSpatialInfo().spatialPaint == getLastPaint())
-                        continue;
-                    handleCollisionImpl(mFT, b, TTag{});
-                    b->getSpatialInfo().spatialPaint = getLastPaint();
-                }
+                    return mCell.hasAnyGroup(toCheck) ||
+                           (checked && mCell.hasDynamicBesides(&base));
+                },
+                [this, mFT](BodyType* mBody)
+                {
+                    handleCollisionImpl(mFT, mBody, TTag{});
+                });
         }
     };
 }
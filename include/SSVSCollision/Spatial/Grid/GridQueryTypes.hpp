@@ -12,11 +12,12 @@ namespace ssvsc
         template <typename TW, typename TGrid>
         struct Base
         {
-            TGrid& grid;
+            // Queries only read the grid.
+            const TGrid& grid;
             Vec2f startPos, pos, lastPos;
             Vec2i startIndex, index;
 
-            Base(TGrid& mGrid, const Vec2i& mPos)
+            Base(const TGrid& mGrid, const Vec2i& mPos)
                 : grid(mGrid), startPos{mPos}, pos{mPos},
                   startIndex{grid.getIdx(Vec2i(mPos))}, index{startIndex}
             {
@@ -28,33 +29,94 @@ namespace ssvsc
                 index = startIndex;
             }
             inline const auto& getLastPos() const noexcept { return lastPos; }
+
+            // Appends the bodies of the current cell accepted by `mFilter`.
+            template <typename TFilter>
+            inline void gather(std::vector<Body<TW>*>& mBodies,
+                const TFilter& mFilter) const
+            {
+                mFilter.forEachIn(grid.getCell(index),
+                    [&mBodies](Body<TW>* mBody)
+                    {
+                        mBodies.emplace_back(mBody);
+                    });
+            }
+
+            // Distance between the start position and the nearest side of
+            // its cell: ring `r` is at least `r - 1` cells plus this away.
+            inline float getCellMargin() const noexcept
+            {
+                const auto& p(startPos);
+                const int cellSize{grid.getCellSize()};
+                const Vec2f min(startIndex * cellSize);
+                const Vec2f max(min + Vec2f(cellSize, cellSize));
+                return std::max(0.f, std::min({p.x - min.x, max.x - p.x,
+                                         p.y - min.y, max.y - p.y}));
+            }
+
+            // Ring of the farthest cell of the grid.
+            inline int getReach() const noexcept
+            {
+                const auto& s(startIndex);
+                return std::max({std::abs(s.x - grid.getIdxXMin()),
+                    std::abs(s.x - grid.getIdxXMax() + 1),
+                    std::abs(s.y - grid.getIdxYMin()),
+                    std::abs(s.y - grid.getIdxYMax() + 1)});
+            }
         };
 
+        // Modes hand their filter to the query: a filter calls a function
+        // on the bodies of a cell it accepts, and can skip whole cells.
         namespace Bodies
         {
             template <typename TW>
             struct All
             {
+                struct Filter
+                {
+                    template <typename TCell, typename TF>
+                    inline void forEachIn(
+                        const TCell& mCell, const TF& mF) const
+                    {
+                        mCell.forEachBody(mF);
+                    }
+                };
+
+                inline static Filter getFilter() noexcept { return {}; }
+
                 template <typename T>
                 inline static void getBodies(
                     std::vector<Body<TW>*>& mBodies, const T& mInternal)
                 {
-                    mBodies =
-                        mInternal.grid.getCell(mInternal.index).getBodies();
+                    mInternal.gather(mBodies, getFilter());
                 }
             };
             template <typename TW>
             struct ByGroup
             {
+                // Cells without a body in `group` are skipped.
+                struct Filter
+                {
+                    Group group;
+
+                    template <typename TCell, typename TF>
+                    inline void forEachIn(
+                        const TCell& mCell, const TF& mF) const
+                    {
+                        mCell.forEachBodyInGroup(group, mF);
+                    }
+                };
+
+                inline static Filter getFilter(Group mGroup) noexcept
+                {
+                    return {mGroup};
+                }
+
                 template <typename T>
                 inline static void getBodies(std::vector<Body<TW>*>& mBodies,
                     const T& mInternal, Group mGroup)
                 {
-                    std::vector<Body<TW>*> result;
-                    for(const auto& b :
-                        mInternal.grid.getCell(mInternal.index).getBodies())
-                        if(b->hasGroup(mGroup)) result.emplace_back(b);
-                    mBodies = result;
+                    mInternal.gather(mBodies, getFilter(mGroup));
                 }
             };
         }
@@ -188,15 +250,16 @@ namespace ssvsc
                 return !finished && this->grid.isIdxValid(this->index);
             }
             inline void step() { finished = true; }
+            // Unordered: `std::sort` needs a strict weak ordering.
             inline bool getSorting(const Body<TW>*, const Body<TW>*)
             {
-                return true;
+                return false;
             }
             inline bool hits(const AABB& mShape)
             {
                 return mShape.contains(Vec2i(this->pos));
             }
-            inline void setOut(const AABB&) {}
+            inline void setOut(const AABB&) { this->lastPos = this->pos; }
         };
 
         template <typename TW, typename TGrid>
@@ -206,7 +269,7 @@ namespace ssvsc
             Vec2i next;
             Vec2f dir, deltaDist, increment, max;
 
-            RayCast(TGrid& mGrid, const Vec2i& mPos, const Vec2f& mDir)
+            RayCast(const TGrid& mGrid, const Vec2i& mPos, const Vec2f& mDir)
                 : Base<TW, TGrid>{mGrid, mPos},
                   cellSize{this->grid.getCellSize()}, dir{mDir},
                   increment{dir * ssvu::toFloat(cellSize)},
@@ -259,6 +322,53 @@ namespace ssvsc
                     this->index.y += next.y;
                 }
             }
+
+            // Ray parameter at which the ray leaves the current cell.
+            inline float getCellExit() const noexcept
+            {
+                if(dir.x == 0) return max.y;
+                if(dir.y == 0) return max.x;
+                return std::min(max.x, max.y);
+            }
+
+            // Closest body accepted by `TMode` whose near sides the ray
+            // crosses, without sorting the candidates: each one gets its
+            // entry parameter from a slab test, and the walk stops in the
+            // cell the closest entry lies in. The walk starts over from the
+            // origin and leaves this query where it is.
+            template <typename TMode, typename... TArgs>
+            inline Body<TW>* firstHit(const TArgs&... mArgs)
+            {
+                if(dir.x == 0 && dir.y == 0) return nullptr;
+
+                Body<TW>* result{nullptr};
+                float best{ssvu::NumLimits<float>::max()};
+                RayCast walk{this->grid, Vec2i(this->startPos), dir};
+                const auto filter(TMode::getFilter(mArgs...));
+
+                for(; walk.isValid(); walk.step())
+                {
+                    filter.forEachIn(this->grid.getCell(walk.index),
+                        [&](Body<TW>* mBody)
+                        {
+                            float t;
+                            if(Utils::isRayEntering(mBody->getShape(),
+                                    this->startPos, dir, best, t) &&
+                                (t < best || result == nullptr))
+                            {
+                                result = mBody;
+                                best = t;
+                            }
+                        });
+
+                    if(result != nullptr && best <= walk.getCellExit()) break;
+                }
+
+                if(result != nullptr)
+                    this->lastPos = this->startPos + dir * best;
+                return result;
+            }
+
             inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
             {
                 return ssvs::getDistEuclidean(
@@ -289,51 +399,165 @@ namespace ssvsc
             inline void setOut(const AABB&) {}
         };
 
+        // Visits the cells covered by `area`, row by row. A body spanning
+        // several of them is only gathered in the first one it shares with
+        // `area`: no marks are needed, so queries stay read-only. Cells are
+        // compared with the ones holding the body, not with its shape,
+        // which may have moved since they were computed.
+        template <typename TW, typename TGrid>
+        struct Area : public Base<TW, TGrid>
+        {
+            AABB area;
+            Vec2i endIndex;
+
+            Area(const TGrid& mGrid, const AABB& mArea)
+                : Base<TW, TGrid>{mGrid, mArea.getPosition()}, area{mArea}
+            {
+                const auto& g(this->grid);
+                this->startIndex = Vec2i{
+                    std::max(g.getIdx(area.getLeft()), g.getIdxXMin()),
+                    std::max(g.getIdx(area.getTop()), g.getIdxYMin())};
+                endIndex = Vec2i{
+                    std::min(g.getIdx(area.getRight()), g.getIdxXMax() - 1),
+                    std::min(g.getIdx(area.getBottom()), g.getIdxYMax() - 1)};
+                this->index = this->startIndex;
+            }
+
+            inline bool isFirstCell(
+                const Body<TW>& mBody, const Vec2i& mCell) const noexcept
+            {
+                const auto first(mBody.getSpatialInfo().getFirstCell());
+                return std::max(first.x, this->startIndex.x) == mCell.x &&
+                       std::max(first.y, this->startIndex.y) == mCell.y;
+            }
+
+            template <typename TFilter>
+            inline void gather(std::vector<Body<TW>*>& mBodies,
+                const TFilter& mFilter) const
+            {
+                const auto& cell(this->index);
+                mFilter.forEachIn(this->grid.getCell(cell),
+                    [this, &mBodies, &cell](Body<TW>* mBody)
+                    {
+                        if(isFirstCell(*mBody, cell))
+                            mBodies.emplace_back(mBody);
+                    });
+            }
+
+            // Number of bodies accepted by `TMode` overlapping `area`,
+            // without gathering them.
+            template <typename TMode, typename... TArgs>
+            inline SizeT count(const TArgs&... mArgs) const
+            {
+                SizeT result{0};
+                const auto filter(TMode::getFilter(mArgs...));
+
+                for(int iY{this->startIndex.y}; iY <= endIndex.y; ++iY)
+                    for(int iX{this->startIndex.x}; iX <= endIndex.x; ++iX)
+                    {
+                        const Vec2i cell{iX, iY};
+                        filter.forEachIn(this->grid.getCell(cell),
+                            [&](const Body<TW>* mBody)
+                            {
+                                if(isFirstCell(*mBody, cell) &&
+                                    mBody->getShape().isOverlapping(area))
+                                    ++result;
+                            });
+                    }
 
+                return result;
+            }
+
+            inline bool isValid()
+            {
+                return this->startIndex.x <= endIndex.x &&
+                       this->index.y <= endIndex.y;
+            }
+            inline void step()
+            {
+                if(++this->index.x <= endIndex.x) return;
 
+                this->index.x = this->startIndex.x;
+                ++this->index.y;
+            }
+            inline bool getSorting(const Body<TW>*, const Body<TW>*)
+            {
+                return false;
+            }
+            inline bool hits(const AABB& mShape)
+            {
+                return mShape.isOverlapping(area);
+            }
+            inline void setOut(const AABB&) { this->lastPos = this->pos; }
+        };
+
+        // Visits the cells ring by ring from the centre, walking the shared
+        // `RingTable`. Rings that cannot hold a point within `distance`
+        // and cells outside the grid are skipped.
         template <typename TW, typename TGrid>
         struct Distance : public Base<TW, TGrid>
         {
-            int cellSize, distance, cellRadius;
-            std::queue<Vec2i> offsets;
+            int cellSize, distance, lastRing, ring{0};
+            float distanceSq;
+            const Impl::RingTable& rings;
+            SizeT cell{0};
 
-            Distance(TGrid& mGrid, const Vec2i& mPos, int mDistance)
-                : Base<TW, TGrid>{mGrid, mPos},
-                  cellSize{this->grid.getCellSize()}, distance{mDistance},
-                  cellRadius{distance / cellSize}
+            // Last ring that may hold a point within `distance`. No need
+            // to go past the farthest cell of the grid.
+            inline int getLastRing() const noexcept
             {
-                SSVU_ASSERT(cellSize != 0);
+                const int margin(this->getCellMargin());
+                if(distance < margin) return 0;
 
-                for(int iRadius{0}; iRadius < cellRadius + 1; ++iRadius)
-                {
-                    for(int iY{-iRadius}; iY <= iRadius; ++iY)
-                    {
-                        offsets.emplace(iRadius, iY);
-                        if(-iRadius != iRadius) offsets.emplace(-iRadius, iY);
-                    }
-                    for(int iX{-iRadius + 1}; iX <= iRadius - 1; ++iX)
+                return std::min(
+                    (distance - margin) / cellSize + 1, this->getReach());
+            }
+
+            // Moves to the first cell inside the grid, from `cell` of
+            // `ring` on.
+            inline void seek() noexcept
+            {
+                for(; ring <= lastRing; ++ring, cell = 0)
+                    for(; cell < Impl::RingTable::getRingSize(ring); ++cell)
                     {
-                        offsets.emplace(iX, iRadius);
-                        offsets.emplace(iX, -iRadius);
+                        const Vec2i idx{this->startIndex + rings(ring, cell)};
+                        if(!this->grid.isIdxValid(idx)) continue;
+
+                        this->index = idx;
+                        return;
                     }
-                }
             }
 
-            inline bool isValid()
+            Distance(const TGrid& mGrid, const Vec2i& mPos, int mDistance)
+                : Base<TW, TGrid>{mGrid, mPos},
+                  cellSize{this->grid.getCellSize()}, distance{mDistance},
+                  lastRing{getLastRing()},
+                  distanceSq(float(distance) * float(distance)),
+                  rings(Impl::getRingTable())
             {
-                return !offsets.empty() && this->grid.isIdxValid(this->index);
+                SSVU_ASSERT(cellSize != 0);
+                seek();
             }
+
+            inline void reset()
+            {
+                Base<TW, TGrid>::reset();
+                ring = 0;
+                cell = 0;
+                seek();
+            }
+            inline bool isValid() { return ring <= lastRing; }
             inline void step()
             {
                 this->lastPos = this->pos;
-                this->index = this->startIndex + offsets.front();
-                if(!offsets.empty()) offsets.pop();
+                ++cell;
+                seek();
             }
             inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
             {
-                return ssvs::getDistEuclidean(
+                return ssvs::getDistSquaredEuclidean(
                            mA->getPosition(), this->startPos) >
-                       ssvs::getDistEuclidean(
+                       ssvs::getDistSquaredEuclidean(
                            mB->getPosition(), this->startPos);
             }
             inline bool hits(const AABB& mShape)
@@ -344,7 +568,7 @@ namespace ssvsc
                                                      : mShape.getBottom()};
 
                 if(ssvs::getDistSquaredEuclidean(test, this->startPos) >
-                    pow(distance, 2))
+                    distanceSq)
                     return false;
 
                 this->lastPos = Vec2f(test);
@@ -352,6 +576,83 @@ namespace ssvsc
             }
             inline void setOut(const AABB&) {}
         };
+
+        // Gathers the `k` bodies closest to the start position in a single
+        // step, walking the rings until the farthest of them is nearer
+        // than the next ring can be. Distances are measured to the shapes,
+        // and the bodies are yielded from the closest. Only the first
+        // rings are in the `RingTable`: the walk usually stops long before
+        // the reach of the grid.
+        template <typename TW, typename TGrid>
+        struct Nearest : public Base<TW, TGrid>
+        {
+            SizeT k;
+            int cellSize, lastRing;
+            float margin;
+            const Impl::RingTable& rings;
+            bool done{false};
+
+            Nearest(const TGrid& mGrid, const Vec2i& mPos, SizeT mK)
+                : Base<TW, TGrid>{mGrid, mPos}, k{mK},
+                  cellSize{this->grid.getCellSize()},
+                  lastRing{this->getReach()},
+                  margin{this->getCellMargin()},
+                  rings(Impl::getRingTable())
+            {
+                SSVU_ASSERT(cellSize != 0);
+            }
+
+            template <typename TFilter>
+            inline void gather(std::vector<Body<TW>*>& mBodies,
+                const TFilter& mFilter) const
+            {
+                if(k == 0) return;
+
+                Impl::NearestHeap<Body<TW>> heap{mBodies, k, this->startPos};
+
+                for(int iRing{0}; iRing <= lastRing; ++iRing)
+                {
+                    // Bodies not seen yet only overlap this ring or the
+                    // next ones.
+                    if(iRing > 0 && heap.isFull())
+                    {
+                        const float bound{(iRing - 1) * cellSize + margin};
+                        if(heap.getWorstDistSq() <= bound * bound) break;
+                    }
+
+                    const auto size(Impl::RingTable::getRingSize(iRing));
+                    for(SizeT i{0}; i < size; ++i)
+                    {
+                        const Vec2i idx{this->startIndex + rings(iRing, i)};
+                        if(!this->grid.isIdxValid(idx)) continue;
+
+                        mFilter.forEachIn(this->grid.getCell(idx),
+                            [&heap](Body<TW>* mBody)
+                            {
+                                heap.add(mBody);
+                            });
+                    }
+                }
+            }
+
+            inline void reset()
+            {
+                Base<TW, TGrid>::reset();
+                done = false;
+            }
+            inline bool isValid() { return !done; }
+            inline void step() { done = true; }
+            inline bool getSorting(const Body<TW>* mA, const Body<TW>* mB)
+            {
+                return Utils::getDistSquared(mA->getShape(), this->startPos) >
+                       Utils::getDistSquared(mB->getShape(), this->startPos);
+            }
+            inline bool hits(const AABB&) { return true; }
+            inline void setOut(const AABB& mShape)
+            {
+                this->lastPos = Utils::getClosestPoint(mShape, this->startPos);
+            }
+        };
     }
 }
 
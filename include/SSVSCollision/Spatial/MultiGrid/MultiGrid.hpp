@@ -0,0 +1,213 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_MULTIGRID
+#define SSVSC_SPATIAL_MULTIGRID
+
+#include "SSVSCollision/Spatial/MultiGrid/MultiGridInfo.hpp"
+
+namespace ssvsc
+{
+    // Hierarchy of grids covering the same area, with cell sizes doubling
+    // from one level to the next. Every body lives in the finest level
+    // whose cells are at least as big as the body, so it covers at most
+    // 2x2 cells whatever its size.
+    // Each cell has two lists: `residents`, the bodies of its own level,
+    // and `guests`, the bodies of finer levels overlapping it. A body
+    // checks the residents and guests of its own cells (same level and
+    // finer bodies) and the residents of its cells on coarser levels.
+    //
+    // Queries see the finest level: `getCell` returns a view over the
+    // residents of the cells containing the requested one on every level,
+    // so all `GridQueryTypes` work unchanged.
+    template <typename TW>
+    class MultiGrid
+    {
+    public:
+        using BaseType = Base<TW>;
+        using BodyType = Body<TW>;
+        using CellType = Cell<TW>;
+        using SpatialInfoType = MultiGridInfo<TW>;
+
+        // Walks the levels lazily: views hold no state but the finest
+        // cell, so any number of them can be used at once.
+        class CellView
+        {
+        private:
+            const MultiGrid& grid;
+            Vec2i idx;
+
+        public:
+            inline CellView(const MultiGrid& mGrid, const Vec2i& mIdx) noexcept
+                : grid(mGrid),
+                  idx{mIdx}
+            {
+            }
+
+            template <typename TF>
+            inline void forEachBody(const TF& mF) const
+            {
+                if(!grid.isIdxValid(idx)) return;
+
+                // The finest cell starts at a multiple of every cell size:
+                // the coarse cell containing that corner contains all of
+                // it.
+                const int x{idx.x * grid.getCellSize()};
+                const int y{idx.y * grid.getCellSize()};
+
+                for(SizeT i{0}; i < grid.getLevelCount(); ++i)
+                    grid.getResidents(i, grid.getIdx(i, x), grid.getIdx(i, y))
+                        .forEachBody(mF);
+            }
+            // Levels without a body in `mGroup` are skipped.
+            template <typename TF>
+            inline void forEachBodyInGroup(Group mGroup, const TF& mF) const
+            {
+                if(!grid.isIdxValid(idx)) return;
+
+                const int x{idx.x * grid.getCellSize()};
+                const int y{idx.y * grid.getCellSize()};
+
+                for(SizeT i{0}; i < grid.getLevelCount(); ++i)
+                    grid.getResidents(i, grid.getIdx(i, x), grid.getIdx(i, y))
+                        .forEachBodyInGroup(mGroup, mF);
+            }
+        };
+
+    private:
+        struct Level
+        {
+            int cols, rows, cellSize, offset;
+            std::vector<CellType> residents, guests;
+        };
+
+        std::vector<Level> levels;
+        std::vector<Impl::PaintContext> paints{1};
+
+        inline SizeT getCellIdx(const Level& mL, int mX, int mY) const
+            noexcept
+        {
+            SSVU_ASSERT(mX + mL.offset >= 0 && mX + mL.offset < mL.cols);
+            SSVU_ASSERT(mY + mL.offset >= 0 && mY + mL.offset < mL.rows);
+            return ssvu::get1DIdxFrom2D(
+                mX + mL.offset, mY + mL.offset, mL.cols);
+        }
+
+    public:
+        // `mCellSize` is the cell size of the finest level. Coarser levels
+        // cover the same area with fewer, bigger cells.
+        inline MultiGrid(int mCols, int mRows, int mCellSize,
+            int mOffset = 0, SizeT mLevelCount = 4)
+        {
+            SSVU_ASSERT(mLevelCount > 0);
+
+            for(SizeT i{0}; i < mLevelCount; ++i)
+            {
+                const int scale{1 << i};
+                const auto ceilDiv([scale](int mX)
+                    {
+                        return (mX + scale - 1) / scale;
+                    });
+
+                Level l;
+                l.cellSize = mCellSize * scale;
+                l.offset = ceilDiv(mOffset);
+                l.cols = ceilDiv(mCols - mOffset) + l.offset;
+                l.rows = ceilDiv(mRows - mOffset) + l.offset;
+                l.residents.resize(l.cols * l.rows);
+                l.guests.resize(l.cols * l.rows);
+
+                levels.emplace_back(std::move(l));
+            }
+        }
+
+        inline SizeT getLevelCount() const noexcept { return levels.size(); }
+
+        // Finest level whose cells are at least as big as `mShape`.
+        inline SizeT getLevelFor(const AABB& mShape) const noexcept
+        {
+            const int extent{std::max(mShape.getWidth(), mShape.getHeight())};
+
+            SizeT result{0};
+            while(result + 1 < levels.size() &&
+                  extent > levels[result].cellSize)
+                ++result;
+
+            return result;
+        }
+
+        inline int getIdx(SizeT mLevel, int mValue) const noexcept
+        {
+            return Impl::floorDiv(mValue, levels[mLevel].cellSize);
+        }
+        inline CellType& getResidents(SizeT mLevel, int mX, int mY)
+        {
+            auto& l(levels[mLevel]);
+            return l.residents[getCellIdx(l, mX, mY)];
+        }
+        inline const CellType& getResidents(SizeT mLevel, int mX, int mY) const
+        {
+            const auto& l(levels[mLevel]);
+            return l.residents[getCellIdx(l, mX, mY)];
+        }
+        inline CellType& getGuests(SizeT mLevel, int mX, int mY)
+        {
+            auto& l(levels[mLevel]);
+            return l.guests[getCellIdx(l, mX, mY)];
+        }
+
+        inline void setThreadCount(SizeT mCount)
+        {
+            paints.resize(std::max(mCount, SizeT(1)));
+        }
+        inline auto& getPaint(SizeT mThread) noexcept
+        {
+            SSVU_ASSERT(mThread < paints.size());
+            return paints[mThread];
+        }
+        inline void refresh() noexcept {}
+
+        // Finest level geometry, used by `GridQueryTypes`.
+        inline int getIdxXMin() const noexcept { return -levels[0].offset; }
+        inline int getIdxYMin() const noexcept { return -levels[0].offset; }
+        inline int getIdxXMax() const noexcept
+        {
+            return levels[0].cols - levels[0].offset;
+        }
+        inline int getIdxYMax() const noexcept
+        {
+            return levels[0].rows - levels[0].offset;
+        }
+        inline int getCellSize() const noexcept { return levels[0].cellSize; }
+
+        inline int getIdx(int mValue) const noexcept
+        {
+            return getIdx(0, mValue);
+        }
+        inline Vec2i getIdx(const Vec2i& mPos) const noexcept
+        {
+            return {getIdx(mPos.x), getIdx(mPos.y)};
+        }
+
+        inline bool isIdxValid(const Vec2i& mIdx) const noexcept
+        {
+            return mIdx.x >= getIdxXMin() && mIdx.x < getIdxXMax() &&
+                   mIdx.y >= getIdxYMin() && mIdx.y < getIdxYMax();
+        }
+        inline bool isIdxValid(int mX1, int mY1, int mX2, int mY2) const
+            noexcept
+        {
+            return mX1 >= getIdxXMin() && mX2 < getIdxXMax() &&
+                   mY1 >= getIdxYMin() && mY2 < getIdxYMax();
+        }
+
+        // Residents of every level overlapping the finest cell `mIdx`.
+        inline CellView getCell(const Vec2i& mIdx) const noexcept
+        {
+            return {*this, mIdx};
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,273 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_MULTIGRIDINFO
+#define SSVSC_SPATIAL_MULTIGRIDINFO
+
+namespace ssvsc
+{
+    template <typename TW>
+    class MultiGridInfo
+    {
+    public:
+        using SpatialType = typename TW::SpatialType;
+        using BaseType = Base<TW>;
+        using BodyType = Body<TW>;
+        using SensorType = Sensor<TW>;
+        using CellType = Cell<TW>;
+        using MembershipType = Impl::CellMembership<CellType>;
+
+        // What `setState` needs to rebuild the same cells.
+        struct State
+        {
+            AABB shape;
+            SizeT level;
+            int startX, startY, endX, endY;
+            bool isStatic, inCells, invalid;
+        };
+
+    private:
+        SpatialType& grid;
+        BaseType& base;
+
+        // `residentCells` and `guestCells` hold this body, `scanCells` are
+        // the cells looked at to find candidates.
+        std::vector<MembershipType> residentCells, guestCells;
+        std::vector<CellType*> scanCells;
+        // The shape the edges were computed from.
+        AABB shape;
+        SizeT level{0}, oldLevel{0};
+        bool isStatic{false}, oldIsStatic{false};
+        int startX{0}, startY{0}, endX{0}, endY{0}, oldStartX{-1},
+            oldStartY{-1}, oldEndX{-1}, oldEndY{-1};
+        bool invalid{true};
+
+        inline const AABB& getShapeImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).getShape();
+        }
+        inline const AABB& getShapeImpl(SensorTag) const noexcept
+        {
+            return ssvu::castUp<SensorType>(base).getShape();
+        }
+        inline bool isStaticImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).isStatic();
+        }
+        inline bool isStaticImpl(SensorTag) const noexcept { return false; }
+        inline void handleCollisionImpl(FT mFT, BodyType* mBody, BodyTag) const
+            noexcept
+        {
+            SSVU_ASSERT(mBody != nullptr);
+            ssvu::castUp<BodyType>(base).handleCollision(mFT, mBody);
+        }
+        inline void handleCollisionImpl(
+            FT mFT, BodyType* mBody, SensorTag) const noexcept
+        {
+            SSVU_ASSERT(mBody != nullptr);
+            ssvu::castUp<SensorType>(base).handleCollision(mFT, mBody);
+        }
+
+        // The edges are computed on the finest level, like `GridInfo`
+        // does: the cells of every coarser level only depend on them.
+        template <typename TTag>
+        inline void calcEdges()
+        {
+            shape = getShapeImpl(TTag{});
+
+            oldLevel = level;
+            oldIsStatic = isStatic;
+            oldStartX = startX;
+            oldStartY = startY;
+            oldEndX = endX;
+            oldEndY = endY;
+
+            level = grid.getLevelFor(shape);
+            isStatic = isStaticImpl(TTag{});
+            startX = grid.getIdx(shape.getLeft());
+            startY = grid.getIdx(shape.getTop());
+            endX = grid.getIdx(shape.getRight());
+            endY = grid.getIdx(shape.getBottom());
+
+            // `setStatic` moves the body to the other layer of its cells.
+            if(oldLevel != level || oldIsStatic != isStatic ||
+                oldStartX != startX || oldStartY != startY ||
+                oldEndX != endX || oldEndY != endY)
+                calcCells<TTag>();
+            else
+                invalid = false;
+        }
+        template <typename TF>
+        inline void forEachLevelCell(SizeT mLevel, const TF& mF)
+        {
+            const int sX{grid.getIdx(mLevel, shape.getLeft())},
+                sY{grid.getIdx(mLevel, shape.getTop())},
+                eX{grid.getIdx(mLevel, shape.getRight())},
+                eY{grid.getIdx(mLevel, shape.getBottom())};
+
+            for(int iX{sX}; iX <= eX; ++iX)
+                for(int iY{sY}; iY <= eY; ++iY) mF(iX, iY);
+        }
+        template <typename TTag>
+        inline void calcCells()
+        {
+            clear<TTag>();
+
+            if(!grid.isIdxValid(startX, startY, endX, endY))
+            {
+                base.setOutOfBounds(true);
+                return;
+            }
+
+            forEachLevelCell(level, [this](int mX, int mY)
+                {
+                    auto& c(grid.getResidents(level, mX, mY));
+                    residentCells.emplace_back(&c);
+                    scanCells.emplace_back(&c);
+                    scanCells.emplace_back(&grid.getGuests(level, mX, mY));
+                });
+
+            for(auto i(level + 1); i < grid.getLevelCount(); ++i)
+                forEachLevelCell(i, [this, i](int mX, int mY)
+                    {
+                        guestCells.emplace_back(&grid.getGuests(i, mX, mY));
+                        scanCells.emplace_back(&grid.getResidents(i, mX, mY));
+                    });
+
+            // Cells point to the memberships: add once the vectors are
+            // filled.
+            for(auto& m : residentCells) m.cell->add(&base, m.idx, TTag{});
+            for(auto& m : guestCells) m.cell->add(&base, m.idx, TTag{});
+
+            invalid = false;
+        }
+        template <typename TTag>
+        inline void clear()
+        {
+            for(const auto& m : residentCells) m.cell->del(m.idx, TTag{});
+            for(const auto& m : guestCells) m.cell->del(m.idx, TTag{});
+            residentCells.clear();
+            guestCells.clear();
+            scanCells.clear();
+        }
+
+    public:
+        inline MultiGridInfo(SpatialType& mGrid, BaseType& mBase) noexcept
+            : grid(mGrid),
+              base(mBase)
+        {
+        }
+
+        template <typename TTag>
+        inline void init()
+        {
+            calcEdges<TTag>();
+            calcCells<TTag>();
+        }
+        inline void invalidate() noexcept { invalid = true; }
+        template <typename TTag>
+        inline void preUpdate()
+        {
+            if(invalid) calcEdges<TTag>();
+        }
+        inline void postUpdate() const noexcept {}
+        template <typename TTag>
+        inline void destroy()
+        {
+            clear<TTag>();
+        }
+        inline void refreshGroups() noexcept
+        {
+            const auto& groups(base.getGroups());
+            for(const auto& m : residentCells) m.cell->changeGroups(groups);
+            for(const auto& m : guestCells) m.cell->changeGroups(groups);
+        }
+
+        inline State getState() const noexcept
+        {
+            return {shape, level, startX, startY, endX, endY, isStatic,
+                !residentCells.empty(), invalid};
+        }
+        // Only touches the cells if the edges, level or layer changed.
+        template <typename TTag>
+        inline void setState(const State& mState)
+        {
+            const bool same{!residentCells.empty() && level == mState.level &&
+                            isStatic == mState.isStatic &&
+                            startX == mState.startX &&
+                            startY == mState.startY &&
+                            endX == mState.endX && endY == mState.endY};
+
+            shape = mState.shape;
+            level = mState.level;
+            isStatic = mState.isStatic;
+            startX = mState.startX;
+            startY = mState.startY;
+            endX = mState.endX;
+            endY = mState.endY;
+
+            if(!mState.inCells)
+                clear<TTag>();
+            else if(!same)
+                calcCells<TTag>();
+
+            invalid = mState.invalid;
+        }
+
+        inline SizeT getLevel() const noexcept { return level; }
+        // Top-left cell of the finest level holding the shape the cells
+        // were computed from: the queries see the body there.
+        inline Vec2i getFirstCell() const noexcept { return {startX, startY}; }
+
+        // Calls `mF` once for every body that may overlap this one.
+        // Concurrent calls must use different thread indices.
+        template <typename TTag, typename TF>
+        inline void forEachCandidate(SizeT mThread, const TF& mF) const
+        {
+            forEachCandidateIn(mThread, [](const CellType&)
+                {
+                    return true;
+                },
+                mF);
+        }
+        // Like `forEachCandidate`, skipping the cells rejected by
+        // `mCellPred`.
+        template <typename TCellPred, typename TF>
+        inline void forEachCandidateIn(
+            SizeT mThread, const TCellPred& mCellPred, const TF& mF) const
+        {
+            auto& paint(grid.getPaint(mThread));
+            paint.begin();
+
+            for(const auto& c : scanCells)
+            {
+                if(!mCellPred(*c)) continue;
+
+                c->forEachBody([&paint, &mF](BodyType* mBody)
+                    {
+                        if(paint.paint(mBody->getSlot())) mF(mBody);
+                    });
+            }
+        }
+        // Like `GridInfo::handleCollisions`.
+        template <typename TTag>
+        inline void handleCollisions(FT mFT)
+        {
+            const auto& toCheck(base.getGroupsToCheck());
+            constexpr bool checked{std::is_same<TTag, BodyTag>{}};
+
+            forEachCandidateIn(0, [this, &toCheck](const CellType& mCell)
+                {
+                    return mCell.hasAnyGroup(toCheck) ||
+                           (checked && mCell.hasDynamicBesides(&base));
+                },
+                [this, mFT](BodyType* mBody)
+                {
+                    handleCollisionImpl(mFT, mBody, TTag{});
+                });
+        }
+    };
+}
+
+#endif
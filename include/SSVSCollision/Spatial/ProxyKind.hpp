@@ -0,0 +1,22 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_PROXYKIND
+#define SSVSC_SPATIAL_PROXYKIND
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // What a proxy of a pair-based backend stands for.
+        enum class ProxyKind : std::uint8_t
+        {
+            Body,
+            Static,
+            Sensor
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,166 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_SAPINFO
+#define SSVSC_SPATIAL_SAPINFO
+
+namespace ssvsc
+{
+    template <typename TW>
+    class SAPInfo
+    {
+    public:
+        using SpatialType = typename TW::SpatialType;
+        using BaseType = Base<TW>;
+        using BodyType = Body<TW>;
+        using SensorType = Sensor<TW>;
+
+        // What `setState` needs to restore the same pairs.
+        struct State
+        {
+            AABB shape;
+            Impl::ProxyKind kind;
+            bool inserted, invalid;
+        };
+
+    private:
+        SpatialType& sap;
+        BaseType& base;
+        SizeT proxy{0};
+        Impl::ProxyKind kind;
+        bool inserted{false}, invalid{true};
+
+        inline const AABB& getShapeImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).getShape();
+        }
+        inline const AABB& getShapeImpl(SensorTag) const noexcept
+        {
+            return ssvu::castUp<SensorType>(base).getShape();
+        }
+        inline Impl::ProxyKind getKindImpl(BodyTag) const noexcept
+        {
+            return ssvu::castUp<BodyType>(base).isStatic()
+                       ? Impl::ProxyKind::Static
+                       : Impl::ProxyKind::Body;
+        }
+        inline Impl::ProxyKind getKindImpl(SensorTag) const noexcept
+        {
+            return Impl::ProxyKind::Sensor;
+        }
+        inline void handleCollisionImpl(FT mFT, BodyType* mBody, BodyTag) const
+            noexcept
+        {
+            SSVU_ASSERT(mBody != nullptr);
+            ssvu::castUp<BodyType>(base).handleCollision(mFT, mBody);
+        }
+        inline void handleCollisionImpl(
+            FT mFT, BodyType* mBody, SensorTag) const noexcept
+        {
+            SSVU_ASSERT(mBody != nullptr);
+            ssvu::castUp<SensorType>(base).handleCollision(mFT, mBody);
+        }
+
+    public:
+        inline SAPInfo(SpatialType& mSAP, BaseType& mBase) noexcept
+            : sap(mSAP),
+              base(mBase)
+        {
+        }
+
+        template <typename TTag>
+        inline void init()
+        {
+            destroy<TTag>();
+
+            kind = getKindImpl(TTag{});
+            proxy = sap.insert(&base, getShapeImpl(TTag{}), kind);
+            inserted = true;
+            invalid = false;
+        }
+        inline void invalidate() noexcept { invalid = true; }
+        template <typename TTag>
+        inline void preUpdate()
+        {
+            if(!invalid) return;
+
+            // Changing kind (e.g. `setStatic`) changes which pairs are
+            // tracked: start over.
+            if(!inserted || kind != getKindImpl(TTag{}))
+            {
+                init<TTag>();
+                return;
+            }
+
+            sap.move(proxy, getShapeImpl(TTag{}));
+            invalid = false;
+        }
+        inline void postUpdate() const noexcept {}
+        inline void refreshGroups() const noexcept {}
+
+        inline State getState() const noexcept
+        {
+            State result{};
+            result.inserted = inserted;
+            result.invalid = invalid;
+            if(!inserted) return result;
+
+            result.shape = sap.getShape(proxy);
+            result.kind = kind;
+            return result;
+        }
+        template <typename TTag>
+        inline void setState(const State& mState)
+        {
+            invalid = mState.invalid;
+
+            if(!mState.inserted)
+            {
+                destroy<TTag>();
+                return;
+            }
+
+            if(!inserted || kind != mState.kind)
+            {
+                destroy<TTag>();
+
+                kind = mState.kind;
+                proxy = sap.insert(&base, mState.shape, kind);
+                inserted = true;
+                return;
+            }
+
+            if(sap.getShape(proxy) != mState.shape)
+                sap.move(proxy, mState.shape);
+        }
+        template <typename TTag>
+        inline void destroy()
+        {
+            if(!inserted) return;
+
+            sap.remove(proxy);
+            inserted = false;
+        }
+
+        // Overlapping pairs are already unique, no deduplication needed.
+        template <typename TTag, typename TF>
+        inline void forEachCandidate(SizeT, const TF& mF) const
+        {
+            if(!inserted) return;
+
+            for(const auto& p : sap.getPairs(proxy))
+                if(!sap.isSensor(p)) mF(sap.getBody(p));
+        }
+        template <typename TTag>
+        inline void handleCollisions(FT mFT)
+        {
+            forEachCandidate<TTag>(0, [this, mFT](BodyType* mBody)
+                {
+                    handleCollisionImpl(mFT, mBody, TTag{});
+                });
+        }
+    };
+}
+
+#endif
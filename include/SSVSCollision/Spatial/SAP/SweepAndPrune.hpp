@@ -0,0 +1,450 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_SPATIAL_SAP
+#define SSVSC_SPATIAL_SAP
+
+#include "SSVSCollision/Spatial/ProxyKind.hpp"
+#include "SSVSCollision/Spatial/SAP/SAPInfo.hpp"
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Static-static and sensor-sensor pairs are never checked by
+        // anyone, so they are not tracked.
+        inline bool mustPair(ProxyKind mA, ProxyKind mB) noexcept
+        {
+            return mA != mB || mA == ProxyKind::Body;
+        }
+    }
+
+    // Sweep-and-prune broadphase: every proxy has a min and a max endpoint
+    // on both axes, kept sorted by insertion sort. Bodies only move a little
+    // every frame, so an update usually swaps a handful of endpoints. The
+    // set of overlapping pairs is updated incrementally from those swaps.
+    // Unlike grids, it does not need a cell size nor bounds.
+    template <typename TW>
+    class SweepAndPrune
+    {
+    public:
+        using BaseType = Base<TW>;
+        using BodyType = Body<TW>;
+        using SpatialInfoType = SAPInfo<TW>;
+
+    private:
+        struct Endpoint
+        {
+            int value;
+            SizeT proxy;
+            bool isMax;
+        };
+        struct Proxy
+        {
+            BaseType* base{nullptr};
+            Impl::ProxyKind kind;
+            SizeT min[2], max[2];
+            std::vector<SizeT> pairs;
+        };
+
+        std::vector<Proxy> proxies;
+        Impl::SlotAllocator slots;
+        std::vector<Endpoint> endpoints[2];
+        int maxExtent[2]{0, 0};
+        SizeT pairCount{0};
+
+        // Mins come before maxes with the same value: touching proxies are
+        // reported as pairs, the narrowphase will discard them.
+        inline static bool isLess(const Endpoint& mA, const Endpoint& mB)
+        {
+            return mA.value < mB.value ||
+                   (mA.value == mB.value && !mA.isMax && mB.isMax);
+        }
+
+        inline SizeT& getIdxOf(const Endpoint& mE, SizeT mAxis) noexcept
+        {
+            auto& p(proxies[mE.proxy]);
+            return mE.isMax ? p.max[mAxis] : p.min[mAxis];
+        }
+        inline bool isOverlapping(SizeT mA, SizeT mB, SizeT mAxis) const
+            noexcept
+        {
+            const auto& a(proxies[mA]);
+            const auto& b(proxies[mB]);
+            return a.min[mAxis] < b.max[mAxis] && b.min[mAxis] < a.max[mAxis];
+        }
+
+        inline void addPair(SizeT mA, SizeT mB)
+        {
+            auto& a(proxies[mA]);
+            auto& b(proxies[mB]);
+            if(!Impl::mustPair(a.kind, b.kind) || ssvu::contains(a.pairs, mB))
+                return;
+
+            a.pairs.emplace_back(mB);
+            b.pairs.emplace_back(mA);
+            ++pairCount;
+        }
+        inline static bool eraseSwap(std::vector<SizeT>& mV, SizeT mX)
+        {
+            for(auto& x : mV)
+            {
+                if(x != mX) continue;
+                x = mV.back();
+                mV.pop_back();
+                return true;
+            }
+            return false;
+        }
+        inline void removePair(SizeT mA, SizeT mB)
+        {
+            if(!eraseSwap(proxies[mA].pairs, mB)) return;
+            eraseSwap(proxies[mB].pairs, mA);
+            --pairCount;
+        }
+
+        inline void swapEndpoints(SizeT mAxis, SizeT mI, SizeT mJ)
+        {
+            auto& eps(endpoints[mAxis]);
+            std::swap(eps[mI], eps[mJ]);
+            getIdxOf(eps[mI], mAxis) = mI;
+            getIdxOf(eps[mJ], mAxis) = mJ;
+        }
+
+        // A min moving down past a max, or a max moving up past a min,
+        // starts an overlap on `mAxis`; the opposite moves end one.
+        inline void sortMinDown(SizeT mAxis, SizeT mI, bool mUpdate)
+        {
+            auto& eps(endpoints[mAxis]);
+            for(; mI > 0 && isLess(eps[mI], eps[mI - 1]); --mI)
+            {
+                const auto& prev(eps[mI - 1]);
+                if(mUpdate && prev.isMax &&
+                    isOverlapping(eps[mI].proxy, prev.proxy, 1 - mAxis))
+                    addPair(eps[mI].proxy, prev.proxy);
+
+                swapEndpoints(mAxis, mI - 1, mI);
+            }
+        }
+        inline void sortMinUp(SizeT mAxis, SizeT mI, bool mUpdate)
+        {
+            auto& eps(endpoints[mAxis]);
+            for(; mI + 1 < eps.size() && isLess(eps[mI + 1], eps[mI]); ++mI)
+            {
+                const auto& next(eps[mI + 1]);
+                if(mUpdate && next.isMax) removePair(eps[mI].proxy, next.proxy);
+
+                swapEndpoints(mAxis, mI, mI + 1);
+            }
+        }
+        inline void sortMaxDown(SizeT mAxis, SizeT mI, bool mUpdate)
+        {
+            auto& eps(endpoints[mAxis]);
+            for(; mI > 0 && isLess(eps[mI], eps[mI - 1]); --mI)
+            {
+                const auto& prev(eps[mI - 1]);
+                if(mUpdate && !prev.isMax)
+                    removePair(eps[mI].proxy, prev.proxy);
+
+                swapEndpoints(mAxis, mI - 1, mI);
+            }
+        }
+        inline void sortMaxUp(SizeT mAxis, SizeT mI, bool mUpdate)
+        {
+            auto& eps(endpoints[mAxis]);
+            for(; mI + 1 < eps.size() && isLess(eps[mI + 1], eps[mI]); ++mI)
+            {
+                const auto& next(eps[mI + 1]);
+                if(mUpdate && !next.isMax &&
+                    isOverlapping(eps[mI].proxy, next.proxy, 1 - mAxis))
+                    addPair(eps[mI].proxy, next.proxy);
+
+                swapEndpoints(mAxis, mI, mI + 1);
+            }
+        }
+
+        inline static int getMin(const AABB& mShape, SizeT mAxis) noexcept
+        {
+            return mAxis == 0 ? mShape.getLeft() : mShape.getTop();
+        }
+        inline static int getMax(const AABB& mShape, SizeT mAxis) noexcept
+        {
+            return mAxis == 0 ? mShape.getRight() : mShape.getBottom();
+        }
+        inline void updateExtent(const AABB& mShape) noexcept
+        {
+            maxExtent[0] = std::max(maxExtent[0], mShape.getWidth());
+            maxExtent[1] = std::max(maxExtent[1], mShape.getHeight());
+        }
+
+    public:
+        inline void setThreadCount(SizeT) noexcept {}
+        inline void refresh() noexcept {}
+
+        inline SizeT insert(
+            BaseType* mBase, const AABB& mShape, Impl::ProxyKind mKind)
+        {
+            const auto id(slots.acquire());
+            if(id >= proxies.size()) proxies.resize(id + 1);
+
+            auto& p(proxies[id]);
+            p.base = mBase;
+            p.kind = mKind;
+            p.pairs.clear();
+            updateExtent(mShape);
+
+            // The new endpoints start past the end, where nothing overlaps
+            // them. Pairs are only tracked while sorting the second axis,
+            // when the first one is already in place.
+            for(SizeT axis{0}; axis < 2; ++axis)
+            {
+                auto& eps(endpoints[axis]);
+                p.min[axis] = eps.size();
+                eps.push_back({getMin(mShape, axis), id, false});
+                p.max[axis] = eps.size();
+                eps.push_back({getMax(mShape, axis), id, true});
+
+                sortMinDown(axis, p.min[axis], axis == 1);
+                sortMaxDown(axis, p.max[axis], axis == 1);
+            }
+
+            return id;
+        }
+        inline void move(SizeT mId, const AABB& mShape)
+        {
+            auto& p(proxies[mId]);
+            updateExtent(mShape);
+
+            for(SizeT axis{0}; axis < 2; ++axis)
+            {
+                auto& eps(endpoints[axis]);
+                const int newMin{getMin(mShape, axis)},
+                    newMax{getMax(mShape, axis)},
+                    oldMin{eps[p.min[axis]].value},
+                    oldMax{eps[p.max[axis]].value};
+
+                // Grow first, then shrink, so that a min never has to
+                // cross its own max.
+                if(newMin < oldMin)
+                {
+                    eps[p.min[axis]].value = newMin;
+                    sortMinDown(axis, p.min[axis], true);
+                }
+                if(newMax > oldMax)
+                {
+                    eps[p.max[axis]].value = newMax;
+                    sortMaxUp(axis, p.max[axis], true);
+                }
+                if(newMin > oldMin)
+                {
+                    eps[p.min[axis]].value = newMin;
+                    sortMinUp(axis, p.min[axis], true);
+                }
+                if(newMax < oldMax)
+                {
+                    eps[p.max[axis]].value = newMax;
+                    sortMaxDown(axis, p.max[axis], true);
+                }
+            }
+        }
+        inline void remove(SizeT mId)
+        {
+            auto& p(proxies[mId]);
+
+            for(const auto& other : p.pairs)
+            {
+                eraseSwap(proxies[other].pairs, mId);
+                --pairCount;
+            }
+            p.pairs.clear();
+
+            for(SizeT axis{0}; axis < 2; ++axis)
+            {
+                auto& eps(endpoints[axis]);
+                eps[p.max[axis]].value = ssvu::NumLimits<int>::max();
+                sortMaxUp(axis, p.max[axis], false);
+                eps[p.min[axis]].value = ssvu::NumLimits<int>::max();
+                sortMinUp(axis, p.min[axis], false);
+
+                eps.pop_back();
+                eps.pop_back();
+            }
+
+            p.base = nullptr;
+            slots.release(mId);
+        }
+
+        inline const auto& getPairs(SizeT mId) const noexcept
+        {
+            return proxies[mId].pairs;
+        }
+        inline bool isSensor(SizeT mId) const noexcept
+        {
+            return proxies[mId].kind == Impl::ProxyKind::Sensor;
+        }
+        inline BodyType* getBody(SizeT mId) const noexcept
+        {
+            SSVU_ASSERT(!isSensor(mId));
+            return &ssvu::castUp<BodyType>(*proxies[mId].base);
+        }
+        inline SizeT getPairCount() const noexcept { return pairCount; }
+
+        // Shape `mId` was last inserted or moved with.
+        inline AABB getShape(SizeT mId) const noexcept
+        {
+            const auto& p(proxies[mId]);
+            return AABB{endpoints[0][p.min[0]].value,
+                endpoints[0][p.max[0]].value, endpoints[1][p.min[1]].value,
+                endpoints[1][p.max[1]].value};
+        }
+
+        // Bounds of everything inserted so far.
+        inline AABB getBounds() const noexcept
+        {
+            if(endpoints[0].empty()) return AABB{};
+            return AABB{endpoints[0].front().value,
+                endpoints[0].back().value, endpoints[1].front().value,
+                endpoints[1].back().value};
+        }
+
+        // Calls `mF` for every body whose bounds overlap `mArea`. Only the
+        // x endpoints between `left - maxExtent` and `right` are scanned.
+        template <typename TF>
+        inline void forEachInBounds(const AABB& mArea, const TF& mF) const
+        {
+            const auto& epsX(endpoints[0]);
+            const auto& epsY(endpoints[1]);
+            const int left{mArea.getLeft()}, right{mArea.getRight()},
+                top{mArea.getTop()}, bottom{mArea.getBottom()};
+
+            const Endpoint first{left - maxExtent[0], 0, false};
+            auto itr(std::lower_bound(
+                std::begin(epsX), std::end(epsX), first, &isLess));
+
+            for(; itr != std::end(epsX) && itr->value <= right; ++itr)
+            {
+                if(itr->isMax) continue;
+
+                const auto& p(proxies[itr->proxy]);
+                if(p.kind == Impl::ProxyKind::Sensor ||
+                    epsX[p.max[0]].value < left ||
+                    epsY[p.min[1]].value > bottom ||
+                    epsY[p.max[1]].value < top)
+                    continue;
+
+                mF(getBody(itr->proxy));
+            }
+        }
+
+        // Calls `mF` for every body crossed by the segment from `mStart` to
+        // `mEnd`.
+        template <typename TF>
+        inline void forEachOnSegment(
+            const Vec2f& mStart, const Vec2f& mEnd, const TF& mF) const
+        {
+            const Vec2i s(mStart), e(mEnd);
+            const auto delta(mEnd - mStart);
+            float t;
+
+            forEachInBounds(AABB{std::min(s.x, e.x), std::max(s.x, e.x),
+                                std::min(s.y, e.y), std::max(s.y, e.y)},
+                [&](BodyType* mBody)
+                {
+                    if(Utils::isSegmentOverlapping(
+                           mBody->getShape(), mStart, delta, t))
+                        mF(mBody);
+                });
+        }
+    };
+
+    namespace BoundsQueryTypes
+    {
+        template <typename TW, typename TS>
+        struct Point;
+        template <typename TW, typename TS>
+        struct Distance;
+        template <typename TW, typename TS>
+        struct RayCast;
+        template <typename TW, typename TS>
+        struct OrthoLeft;
+        template <typename TW, typename TS>
+        struct OrthoRight;
+        template <typename TW, typename TS>
+        struct OrthoUp;
+        template <typename TW, typename TS>
+        struct OrthoDown;
+        template <typename TW, typename TS>
+        struct Area;
+        template <typename TW, typename TS>
+        struct Nearest;
+        namespace Bodies
+        {
+            template <typename TW>
+            struct All;
+            template <typename TW>
+            struct ByGroup;
+        }
+    }
+
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::Point>
+    {
+        using Type = BoundsQueryTypes::Point<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::Distance>
+    {
+        using Type = BoundsQueryTypes::Distance<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::RayCast>
+    {
+        using Type = BoundsQueryTypes::RayCast<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::OrthoLeft>
+    {
+        using Type = BoundsQueryTypes::OrthoLeft<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::OrthoRight>
+    {
+        using Type = BoundsQueryTypes::OrthoRight<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::OrthoUp>
+    {
+        using Type = BoundsQueryTypes::OrthoUp<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::OrthoDown>
+    {
+        using Type = BoundsQueryTypes::OrthoDown<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::Area>
+    {
+        using Type = BoundsQueryTypes::Area<TW, SweepAndPrune<TW>>;
+    };
+    template <typename TW>
+    struct QueryTypeDispatcher<TW, SweepAndPrune<TW>, QueryType::Nearest>
+    {
+        using Type = BoundsQueryTypes::Nearest<TW, SweepAndPrune<TW>>;
+    };
+
+    template <typename TW>
+    struct QueryModeDispatcher<TW, SweepAndPrune<TW>, QueryMode::All>
+    {
+        using Type = BoundsQueryTypes::Bodies::All<TW>;
+    };
+    template <typename TW>
+    struct QueryModeDispatcher<TW, SweepAndPrune<TW>, QueryMode::ByGroup>
+    {
+        using Type = BoundsQueryTypes::Bodies::ByGroup<TW>;
+    };
+}
+
+#include "SSVSCollision/Spatial/BoundsQueryTypes.hpp"
+
+#endif
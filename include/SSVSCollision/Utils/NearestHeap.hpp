@@ -0,0 +1,84 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_UTILS_NEARESTHEAP
+#define SSVSC_UTILS_NEARESTHEAP
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Keeps the `k` bodies closest to `pos` seen so far, as a max-heap
+        // on their squared distance appended to a candidate vector. Bodies
+        // added twice are only kept once.
+        template <typename TBody>
+        class NearestHeap
+        {
+        private:
+            std::vector<TBody*>& bodies;
+            SizeT first, k;
+            Vec2f pos;
+
+            inline auto getBegin() noexcept
+            {
+                return std::begin(bodies) + first;
+            }
+            inline float getDistSq(const TBody* mBody) const noexcept
+            {
+                return Utils::getDistSquared(mBody->getShape(), pos);
+            }
+            inline bool isCloser(const TBody* mA, const TBody* mB) const
+                noexcept
+            {
+                return getDistSq(mA) < getDistSq(mB);
+            }
+
+        public:
+            inline NearestHeap(
+                std::vector<TBody*>& mBodies, SizeT mK, const Vec2f& mPos)
+                : bodies(mBodies), first{mBodies.size()}, k{mK}, pos{mPos}
+            {
+            }
+
+            inline bool isFull() const noexcept
+            {
+                return bodies.size() - first >= k;
+            }
+
+            // Squared distance of the farthest body kept.
+            inline float getWorstDistSq() const noexcept
+            {
+                SSVU_ASSERT(bodies.size() > first);
+                return getDistSq(bodies[first]);
+            }
+
+            inline void add(TBody* mBody)
+            {
+                if(k == 0) return;
+
+                const auto cmp([this](const TBody* mA, const TBody* mB)
+                    {
+                        return isCloser(mA, mB);
+                    });
+
+                if(isFull() && getDistSq(mBody) >= getWorstDistSq()) return;
+                if(std::find(getBegin(), std::end(bodies), mBody) !=
+                    std::end(bodies))
+                    return;
+
+                if(isFull())
+                {
+                    std::pop_heap(getBegin(), std::end(bodies), cmp);
+                    bodies.back() = mBody;
+                }
+                else
+                    bodies.emplace_back(mBody);
+
+                std::push_heap(getBegin(), std::end(bodies), cmp);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,45 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_UTILS_PAINTCONTEXT
+#define SSVSC_UTILS_PAINTCONTEXT
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Visited-marking used to report every body only once while
+        // walking several cells. Marks are indexed by body slot and
+        // compared against an epoch, so starting a new traversal is O(1).
+        // A context must only be used by one thread at a time.
+        class PaintContext
+        {
+        private:
+            std::vector<int> marks;
+            int epoch{0};
+
+        public:
+            inline void begin() noexcept
+            {
+                if(++epoch != ssvu::NumLimits<int>::max()) return;
+
+                std::fill(std::begin(marks), std::end(marks), 0);
+                epoch = 1;
+            }
+
+            // Returns `true` the first time `mSlot` is painted during the
+            // current traversal.
+            inline bool paint(SizeT mSlot)
+            {
+                if(mSlot >= marks.size()) marks.resize(mSlot + 1, 0);
+                if(marks[mSlot] == epoch) return false;
+
+                marks[mSlot] = epoch;
+                return true;
+            }
+        };
+    }
+}
+
+#endif
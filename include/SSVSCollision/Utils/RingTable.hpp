@@ -0,0 +1,83 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_UTILS_RINGTABLE
+#define SSVSC_UTILS_RINGTABLE
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Cell offsets around a centre cell, ordered by ring: ring `r` holds
+        // the offsets whose Chebyshev length is `r`. The first rings are
+        // precomputed, farther ones are computed on the fly in the same
+        // order. Immutable once built: see `getRingTable`.
+        class RingTable
+        {
+        public:
+            static constexpr int radius{16};
+
+        private:
+            std::vector<Vec2i> offsets;
+            SizeT ringStarts[radius + 1];
+
+        public:
+            inline RingTable()
+            {
+                offsets.reserve(getRingStart(radius + 1));
+
+                for(int iRing{0}; iRing <= radius; ++iRing)
+                {
+                    ringStarts[iRing] = offsets.size();
+                    for(SizeT i{0}; i < getRingSize(iRing); ++i)
+                        offsets.emplace_back(getOffset(iRing, i));
+                }
+            }
+
+            inline static SizeT getRingSize(int mRing) noexcept
+            {
+                SSVU_ASSERT(mRing >= 0);
+                return mRing == 0 ? 1 : 8 * SizeT(mRing);
+            }
+            // Number of offsets in the rings before `mRing`.
+            inline static SizeT getRingStart(int mRing) noexcept
+            {
+                SSVU_ASSERT(mRing >= 0);
+                const auto side(2 * SizeT(mRing) - 1);
+                return mRing == 0 ? 0 : side * side;
+            }
+
+            // Offset `mIdx` of ring `mRing`: the left and right columns
+            // from the top, then the bottom and top rows from the left.
+            inline static Vec2i getOffset(int mRing, SizeT mIdx) noexcept
+            {
+                SSVU_ASSERT(mIdx < getRingSize(mRing));
+                if(mRing == 0) return {0, 0};
+
+                const int i(mIdx), columns{2 * (2 * mRing + 1)};
+                if(i < columns)
+                    return {i % 2 == 0 ? mRing : -mRing, -mRing + i / 2};
+
+                const int j{i - columns};
+                return {-mRing + 1 + j / 2, j % 2 == 0 ? mRing : -mRing};
+            }
+
+            inline Vec2i operator()(int mRing, SizeT mIdx) const noexcept
+            {
+                if(mRing > radius) return getOffset(mRing, mIdx);
+                return offsets[ringStarts[mRing] + mIdx];
+            }
+        };
+
+        // Table shared by every query. Only built once and never written
+        // to again: concurrent queries read it without locking.
+        inline const RingTable& getRingTable()
+        {
+            static const RingTable result;
+            return result;
+        }
+    }
+}
+
+#endif
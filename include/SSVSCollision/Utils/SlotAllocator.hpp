@@ -0,0 +1,40 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_UTILS_SLOTALLOCATOR
+#define SSVSC_UTILS_SLOTALLOCATOR
+
+namespace ssvsc
+{
+    namespace Impl
+    {
+        // Hands out small, dense indices that are reused after release.
+        class SlotAllocator
+        {
+        private:
+            std::vector<SizeT> freeSlots;
+            SizeT capacity{0};
+
+        public:
+            inline SizeT acquire()
+            {
+                if(freeSlots.empty()) return capacity++;
+
+                const auto result(freeSlots.back());
+                freeSlots.pop_back();
+                return result;
+            }
+            inline void release(SizeT mSlot)
+            {
+                SSVU_ASSERT(mSlot < capacity);
+                freeSlots.emplace_back(mSlot);
+            }
+
+            // One past the highest slot ever handed out.
+            inline SizeT getCapacity() const noexcept { return capacity; }
+        };
+    }
+}
+
+#endif
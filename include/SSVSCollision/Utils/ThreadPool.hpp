@@ -0,0 +1,139 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_UTILS_THREADPOOL
+#define SSVSC_UTILS_THREADPOOL
+
+namespace ssvsc
+{
+    // Minimal fork-join pool used by `World`'s parallel phases.
+    // The calling thread always takes part in the work as thread `0`.
+    // Indices are handed out in small chunks through a shared atomic
+    // counter, so idle threads keep grabbing work until none is left.
+    class ThreadPool
+    {
+    private:
+        using JobFn = void (*)(void*, SizeT);
+
+        std::vector<std::thread> workers;
+        std::mutex mtx;
+        std::condition_variable cvWork, cvDone;
+        JobFn jobFn{nullptr};
+        void* jobCtx{nullptr};
+        SizeT generation{0}, pending{0};
+        bool stopping{false};
+
+        inline void workerLoop(SizeT mThreadIdx)
+        {
+            SizeT lastGeneration{0};
+
+            while(true)
+            {
+                std::unique_lock<std::mutex> lock{mtx};
+                cvWork.wait(lock, [this, lastGeneration]
+                    {
+                        return stopping || generation != lastGeneration;
+                    });
+
+                if(stopping) return;
+                lastGeneration = generation;
+                lock.unlock();
+
+                jobFn(jobCtx, mThreadIdx);
+
+                lock.lock();
+                if(--pending == 0) cvDone.notify_one();
+            }
+        }
+
+        template <typename TF>
+        struct ForEachCtx
+        {
+            TF& fn;
+            std::atomic<SizeT> next{0};
+            SizeT count, chunk;
+
+            inline ForEachCtx(TF& mFn, SizeT mCount, SizeT mChunk) noexcept
+                : fn(mFn),
+                  count{mCount},
+                  chunk{mChunk}
+            {
+            }
+
+            inline static void run(void* mCtx, SizeT mThreadIdx)
+            {
+                auto& ctx(*static_cast<ForEachCtx*>(mCtx));
+
+                for(SizeT i{ctx.next.fetch_add(ctx.chunk)}; i < ctx.count;
+                    i = ctx.next.fetch_add(ctx.chunk))
+                {
+                    const auto end(std::min(i + ctx.chunk, ctx.count));
+                    for(; i < end; ++i) ctx.fn(i, mThreadIdx);
+                }
+            }
+        };
+
+    public:
+        // `mThreadCount` includes the calling thread.
+        inline ThreadPool(SizeT mThreadCount)
+        {
+            SSVU_ASSERT(mThreadCount > 0);
+            for(SizeT i{1}; i < mThreadCount; ++i)
+                workers.emplace_back([this, i]
+                    {
+                        workerLoop(i);
+                    });
+        }
+        inline ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                stopping = true;
+            }
+            cvWork.notify_all();
+            for(auto& w : workers) w.join();
+        }
+
+        inline ThreadPool(const ThreadPool&) = delete;
+        inline ThreadPool& operator=(const ThreadPool&) = delete;
+
+        inline SizeT getThreadCount() const noexcept
+        {
+            return workers.size() + 1;
+        }
+
+        // Calls `mF(index, threadIdx)` for every index in `[0, mCount)` and
+        // returns once all of them have been processed.
+        template <typename TF>
+        inline void forEach(SizeT mCount, TF&& mF, SizeT mChunk = 16)
+        {
+            ForEachCtx<TF> ctx{mF, mCount, mChunk};
+
+            if(workers.empty() || mCount <= mChunk)
+            {
+                ForEachCtx<TF>::run(&ctx, 0);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{mtx};
+                jobFn = &ForEachCtx<TF>::run;
+                jobCtx = &ctx;
+                pending = workers.size();
+                ++generation;
+            }
+            cvWork.notify_all();
+
+            ForEachCtx<TF>::run(&ctx, 0);
+
+            std::unique_lock<std::mutex> lock{mtx};
+            cvDone.wait(lock, [this]
+                {
+                    return pending == 0;
+                });
+        }
+    };
+}
+
+#endif
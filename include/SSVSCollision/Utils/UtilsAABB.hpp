@@ -51,6 +51,136 @@ namespace ssvsc
         {
             return getOverlapX(mA, mB) * getOverlapY(mA, mB);
         }
+
+        // Sorts `mBodies` by decreasing overlap area with `mShape`. Ties
+        // are broken by slot, so that the result does not depend on the
+        // order the spatial backend found the bodies in.
+        template <typename TBody>
+        inline void sortByOverlap(
+            const AABB& mShape, std::vector<TBody*>& mBodies)
+        {
+            ssvu::sort(mBodies, [&mShape](const TBody* mA, const TBody* mB)
+                {
+                    const int a{getOverlapArea(mShape, mA->getShape())};
+                    const int b{getOverlapArea(mShape, mB->getShape())};
+                    return a > b || (a == b && mA->getSlot() < mB->getSlot());
+                });
+        }
+
+        // Slab test of the segment `mStart + t * mDelta`, with `t` in
+        // `[0, 1]`, against a box with `getLeft`/`getRight`/`getTop`/
+        // `getBottom`. On a hit, `mT` is set to the entry parameter.
+        template <typename TBox>
+        inline bool isSegmentOverlapping(const TBox& mBox,
+            const Vec2f& mStart, const Vec2f& mDelta, float& mT) noexcept
+        {
+            const float mins[]{ssvu::toFloat(mBox.getLeft()),
+                ssvu::toFloat(mBox.getTop())};
+            const float maxs[]{ssvu::toFloat(mBox.getRight()),
+                ssvu::toFloat(mBox.getBottom())};
+            const float starts[]{mStart.x, mStart.y};
+            const float deltas[]{mDelta.x, mDelta.y};
+            float tMin{0.f}, tMax{1.f};
+
+            for(SizeT i{0}; i < 2; ++i)
+            {
+                if(deltas[i] == 0.f)
+                {
+                    if(starts[i] < mins[i] || starts[i] > maxs[i])
+                        return false;
+                    continue;
+                }
+
+                float t0{(mins[i] - starts[i]) / deltas[i]};
+                float t1{(maxs[i] - starts[i]) / deltas[i]};
+                if(t0 > t1) std::swap(t0, t1);
+
+                tMin = std::max(tMin, t0);
+                tMax = std::min(tMax, t1);
+                if(tMin > tMax) return false;
+            }
+
+            mT = tMin;
+            return true;
+        }
+
+        // Slab test of the ray `mStart + t * mDir`, with `t` in
+        // `[0, mTMax]`. On a hit, `mT` is set to the entry parameter. Like
+        // `RayCast::hits`, boxes the ray starts inside are not hit.
+        template <typename TBox>
+        inline bool isRayEntering(const TBox& mBox, const Vec2f& mStart,
+            const Vec2f& mDir, float mTMax, float& mT) noexcept
+        {
+            const float mins[]{ssvu::toFloat(mBox.getLeft()),
+                ssvu::toFloat(mBox.getTop())};
+            const float maxs[]{ssvu::toFloat(mBox.getRight()),
+                ssvu::toFloat(mBox.getBottom())};
+            const float starts[]{mStart.x, mStart.y};
+            const float dirs[]{mDir.x, mDir.y};
+            float tMin{-ssvu::NumLimits<float>::max()}, tMax{mTMax};
+
+            for(SizeT i{0}; i < 2; ++i)
+            {
+                if(dirs[i] == 0.f)
+                {
+                    if(starts[i] < mins[i] || starts[i] > maxs[i])
+                        return false;
+                    continue;
+                }
+
+                float t0{(mins[i] - starts[i]) / dirs[i]};
+                float t1{(maxs[i] - starts[i]) / dirs[i]};
+                if(t0 > t1) std::swap(t0, t1);
+
+                tMin = std::max(tMin, t0);
+                tMax = std::min(tMax, t1);
+                if(tMin > tMax) return false;
+            }
+
+            if(tMin < 0.f) return false;
+
+            mT = tMin;
+            return true;
+        }
+
+        // Swept test of `mShape` moving by `mDelta` against `mTarget`. On
+        // a hit, `mT` is set to the time of impact in `[0, 1]` and `mAxis`
+        // to the axis of the sides that meet (0 for x, 1 for y). Boxes
+        // that already overlap are not hit.
+        inline bool isSweepHitting(const AABB& mShape, const Vec2f& mDelta,
+            const AABB& mTarget, float& mT, SizeT& mAxis) noexcept
+        {
+            const AABB expanded{mTarget.getPosition(),
+                mTarget.getHalfSize() + mShape.getHalfSize()};
+            const Vec2f start(mShape.getPosition());
+
+            if(!isRayEntering(expanded, start, mDelta, 1.f, mT)) return false;
+
+            // The latest entry is the time of impact.
+            float entryX{-ssvu::NumLimits<float>::max()};
+            if(mDelta.x != 0.f)
+                entryX = std::min((expanded.getLeft() - start.x) / mDelta.x,
+                    (expanded.getRight() - start.x) / mDelta.x);
+
+            mAxis = entryX == mT ? 0 : 1;
+            return true;
+        }
+
+        // Point of `mShape` closest to `mPos`: `mPos` itself if inside.
+        inline Vec2f getClosestPoint(
+            const AABB& mShape, const Vec2f& mPos) noexcept
+        {
+            return {ssvu::getClamped(mPos.x, ssvu::toFloat(mShape.getLeft()),
+                        ssvu::toFloat(mShape.getRight())),
+                ssvu::getClamped(mPos.y, ssvu::toFloat(mShape.getTop()),
+                    ssvu::toFloat(mShape.getBottom()))};
+        }
+        inline float getDistSquared(
+            const AABB& mShape, const Vec2f& mPos) noexcept
+        {
+            return ssvs::getDistSquaredEuclidean(
+                getClosestPoint(mShape, mPos), mPos);
+        }
     }
 }
 
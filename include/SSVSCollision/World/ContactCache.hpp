@@ -0,0 +1,174 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_CONTACTCACHE
+#define SSVSC_WORLD_CONTACTCACHE
+
+namespace ssvsc
+{
+    template <typename TW>
+    class Body;
+
+    namespace Impl
+    {
+        enum class ContactState
+        {
+            Begin,
+            Stay,
+            // Already touched this frame.
+            Seen
+        };
+
+        // Overlapping pairs of the previous frames, keyed by the slots of
+        // their bodies. Pairs are stored densely and indexed by an
+        // open-addressing table with linear probing. Both keep their
+        // capacity across frames.
+        template <typename TW>
+        class ContactCache
+        {
+        private:
+            using BodyType = Body<TW>;
+
+            struct Pair
+            {
+                BodyType* a;
+                BodyType* b;
+                std::uint64_t key;
+                SizeT frame;
+            };
+
+            static constexpr std::uint32_t empty{0};
+
+            std::vector<Pair> pairs;
+            // Index in `pairs` plus one, or `empty`.
+            std::vector<std::uint32_t> table;
+            SizeT frame{0};
+
+            inline static std::uint64_t getKey(
+                const BodyType& mA, const BodyType& mB) noexcept
+            {
+                const auto a(std::uint64_t(mA.getSlot()));
+                const auto b(std::uint64_t(mB.getSlot()));
+                return a < b ? (a << 32) | b : (b << 32) | a;
+            }
+            inline SizeT getBucket(std::uint64_t mKey) const noexcept
+            {
+                mKey ^= mKey >> 33;
+                mKey *= 0xff51afd7ed558ccdull;
+                mKey ^= mKey >> 33;
+                return SizeT(mKey) & (table.size() - 1);
+            }
+
+            // Bucket holding `mKey`, or the empty bucket where it goes.
+            inline SizeT find(std::uint64_t mKey) const noexcept
+            {
+                auto i(getBucket(mKey));
+                while(table[i] != empty && pairs[table[i] - 1].key != mKey)
+                    i = (i + 1) & (table.size() - 1);
+
+                return i;
+            }
+
+            inline void rebuild(SizeT mCapacity)
+            {
+                table.assign(mCapacity, std::uint32_t{empty});
+                for(SizeT i{0}; i < pairs.size(); ++i)
+                    table[find(pairs[i].key)] = std::uint32_t(i + 1);
+            }
+
+            template <typename TPred, typename TF>
+            inline void removeIf(const TPred& mPred, const TF& mOnEnd)
+            {
+                const auto count(pairs.size());
+
+                for(SizeT i{0}; i < pairs.size();)
+                {
+                    if(!mPred(pairs[i]))
+                    {
+                        ++i;
+                        continue;
+                    }
+
+                    const auto p(pairs[i]);
+                    pairs[i] = pairs.back();
+                    pairs.pop_back();
+                    mOnEnd(*p.a, *p.b);
+                }
+
+                if(pairs.size() != count) rebuild(table.size());
+            }
+
+        public:
+            // Records the overlap of `mA` and `mB` for the current frame.
+            inline ContactState touch(BodyType& mA, BodyType& mB)
+            {
+                // Keep the load factor at or below one half.
+                if((pairs.size() + 1) * 2 > table.size())
+                    rebuild(std::max(SizeT(16), table.size() * 2));
+
+                const auto key(getKey(mA, mB));
+                const auto i(find(key));
+
+                if(table[i] == empty)
+                {
+                    pairs.push_back({&mA, &mB, key, frame});
+                    table[i] = std::uint32_t(pairs.size());
+                    return ContactState::Begin;
+                }
+
+                auto& p(pairs[table[i] - 1]);
+                if(p.frame == frame) return ContactState::Seen;
+
+                p.frame = frame;
+                return ContactState::Stay;
+            }
+
+            // Ends the pairs that were not touched this frame, unless none
+            // of their bodies could touch them (sleeping or static), then
+            // starts a new frame.
+            template <typename TF>
+            inline void endFrame(const TF& mOnEnd)
+            {
+                const auto isIdle([](const BodyType& mBody)
+                    {
+                        return mBody.isAsleep() || mBody.isStatic();
+                    });
+
+                removeIf(
+                    [this, &isIdle](const Pair& mP)
+                    {
+                        if(!mP.a->isAlive() || !mP.b->isAlive()) return true;
+                        return mP.frame != frame &&
+                               !(isIdle(*mP.a) && isIdle(*mP.b));
+                    },
+                    mOnEnd);
+
+                ++frame;
+            }
+
+            // Ends the pairs of destroyed bodies, before they are freed.
+            template <typename TF>
+            inline void purge(const TF& mOnEnd)
+            {
+                removeIf(
+                    [](const Pair& mP)
+                    {
+                        return !mP.a->isAlive() || !mP.b->isAlive();
+                    },
+                    mOnEnd);
+            }
+
+            inline void clear() noexcept
+            {
+                pairs.clear();
+                std::fill(
+                    std::begin(table), std::end(table), std::uint32_t{empty});
+            }
+
+            inline SizeT getCount() const noexcept { return pairs.size(); }
+        };
+    }
+}
+
+#endif
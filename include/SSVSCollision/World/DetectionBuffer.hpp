@@ -0,0 +1,47 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_DETECTIONBUFFER
+#define SSVSC_WORLD_DETECTIONBUFFER
+
+namespace ssvsc
+{
+    template <typename TW>
+    class Body;
+
+    namespace Impl
+    {
+        // Overlap found during the parallel detection phase, dispatched
+        // later on the owning body. Each pair is found once: `resolve` and
+        // `resolveOther` tell which sides resolve against the other.
+        template <typename TW>
+        struct Contact
+        {
+            Body<TW>* other;
+            bool resolve, resolveOther;
+        };
+
+        // Where the contacts of a body ended up: buffer index and range.
+        struct ContactRange
+        {
+            SizeT thread, begin, end;
+        };
+
+        // Per-thread output of the detection phase. Reused across frames.
+        template <typename TW>
+        struct DetectionBuffer
+        {
+            std::vector<Contact<TW>> contacts;
+            SizeT pairTests{0};
+
+            inline void clear() noexcept
+            {
+                contacts.clear();
+                pairTests = 0;
+            }
+        };
+    }
+}
+
+#endif
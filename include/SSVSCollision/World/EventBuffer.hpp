@@ -0,0 +1,73 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_EVENTBUFFER
+#define SSVSC_WORLD_EVENTBUFFER
+
+namespace ssvsc
+{
+    template <typename TW>
+    class Body;
+
+    // How bodies report detections and resolutions, see
+    // `World::setEventMode`.
+    enum class EventMode
+    {
+        // `onDetection` and `onResolution` are called during the update.
+        Inline,
+        // Events are recorded and drained after the update.
+        Deferred
+    };
+
+    // `body` and `other` overlapped: with `EventMode::Inline`, both of
+    // them would have got `onDetection`.
+    template <typename TW>
+    struct DetectionEvent
+    {
+        Body<TW>* body;
+        Body<TW>* other;
+        FT frameTime;
+    };
+
+    // `body` was moved by `resolution` out of `other`.
+    template <typename TW>
+    struct ResolutionEvent
+    {
+        Body<TW>* body;
+        Body<TW>* other;
+        Vec2i resolution;
+    };
+
+    namespace Impl
+    {
+        // Events of the current frame, in the order they happened. Reused
+        // across frames.
+        template <typename TW>
+        struct EventBuffer
+        {
+            std::vector<DetectionEvent<TW>> detections;
+            std::vector<ResolutionEvent<TW>> resolutions;
+
+            inline void clear() noexcept
+            {
+                detections.clear();
+                resolutions.clear();
+            }
+
+            // Drops the events of destroyed bodies, before they are freed.
+            inline void purge()
+            {
+                const auto isDead([](const auto& mE)
+                    {
+                        return !mE.body->isAlive() || !mE.other->isAlive();
+                    });
+
+                ssvu::eraseRemoveIf(detections, isDead);
+                ssvu::eraseRemoveIf(resolutions, isDead);
+            }
+        };
+    }
+}
+
+#endif
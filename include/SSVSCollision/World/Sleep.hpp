@@ -0,0 +1,92 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_SLEEP
+#define SSVSC_WORLD_SLEEP
+
+namespace ssvsc
+{
+    // When enabled, dynamic bodies that stay at rest for `frames`
+    // consecutive frames are put to sleep, together with every body they
+    // resolve against (their island). Sleeping bodies are skipped by
+    // `World::update` until they are touched or changed.
+    struct SleepSettings
+    {
+        bool enabled{false};
+
+        // A body is at rest when its velocity and its last resolution
+        // offset are within these bounds on both axes.
+        float maxVelocity{1.f};
+        int maxResolution{50};
+
+        SizeT frames{60};
+    };
+
+    namespace Impl
+    {
+        // Union-find over the dynamic bodies of a frame, reused across
+        // frames. Each set also gets a ring of its members.
+        class IslandSet
+        {
+        public:
+            static constexpr SizeT none{ssvu::NumLimits<SizeT>::max()};
+
+        private:
+            std::vector<SizeT> parents, firsts, lasts;
+            std::vector<char> ready;
+
+        public:
+            inline void reset(SizeT mCount)
+            {
+                parents.resize(mCount);
+                firsts.assign(mCount, SizeT{none});
+                lasts.assign(mCount, SizeT{none});
+                ready.assign(mCount, true);
+                for(SizeT i{0}; i < mCount; ++i) parents[i] = i;
+            }
+
+            inline SizeT find(SizeT mI) noexcept
+            {
+                while(parents[mI] != mI)
+                {
+                    parents[mI] = parents[parents[mI]];
+                    mI = parents[mI];
+                }
+
+                return mI;
+            }
+            inline void unite(SizeT mA, SizeT mB) noexcept
+            {
+                parents[find(mA)] = find(mB);
+            }
+
+            // A set is ready if none of its members called `setNotReady`.
+            inline void setNotReady(SizeT mI) noexcept
+            {
+                ready[find(mI)] = false;
+            }
+            inline bool isReady(SizeT mI) noexcept { return ready[find(mI)]; }
+
+            // Appends `mI` to the member list of its set. Returns the
+            // previous last member, or `none`.
+            inline SizeT append(SizeT mI) noexcept
+            {
+                const SizeT root{find(mI)}, last{lasts[root]};
+                if(last == none) firsts[root] = mI;
+                lasts[root] = mI;
+                return last;
+            }
+            inline SizeT getFirst(SizeT mRoot) const noexcept
+            {
+                return firsts[mRoot];
+            }
+            inline SizeT getLast(SizeT mRoot) const noexcept
+            {
+                return lasts[mRoot];
+            }
+        };
+    }
+}
+
+#endif
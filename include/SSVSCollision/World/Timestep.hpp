@@ -0,0 +1,33 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_TIMESTEP
+#define SSVSC_WORLD_TIMESTEP
+
+namespace ssvsc
+{
+    // Fixed timestep of `World::advance`: real time is accumulated and
+    // consumed in substeps of `step`. At most `maxSubsteps` run per call;
+    // the time left over beyond that is dropped, so a world that cannot
+    // keep up slows down instead of stepping more and more every call.
+    struct TimestepSettings
+    {
+        FT step{1.f};
+        SizeT maxSubsteps{4};
+    };
+
+    struct AdvanceResult
+    {
+        // Number of `World::update` calls made.
+        SizeT substeps{0};
+        // Whole steps dropped because of `maxSubsteps`.
+        SizeT droppedSteps{0};
+        // Fraction of a step left in the accumulator, in `[0, 1)`: the
+        // weight of the current positions against the previous ones, see
+        // `Body::getInterpolatedPosition`.
+        float alpha{0.f};
+    };
+}
+
+#endif
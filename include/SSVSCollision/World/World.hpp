@@ -5,6 +5,11 @@
 #ifndef SSVSC_WORLD
 #define SSVSC_WORLD
 
+#include "SSVSCollision/World/WorldStats.hpp"
+#include "SSVSCollision/World/Sleep.hpp"
+#include "SSVSCollision/World/Timestep.hpp"
+#include "SSVSCollision/World/WorldState.hpp"
+
 namespace ssvsc
 {
     template <typename TW>
@@ -18,10 +23,15 @@ namespace ssvsc
     template <typename TW>
     struct ResolutionInfo;
 
-    template <template <typename> class TS, template <typename> class TR>
+    // `TGroupCount` is the number of groups bodies can be in. Group masks
+    // are stored in every body and every cell: keep it small.
+    template <template <typename> class TS, template <typename> class TR,
+        SizeT TGroupCount = maxGroups>
     class World
     {
     public:
+        static constexpr SizeT groupCount{TGroupCount};
+        using GroupBitsetType = GroupBitsetOf<TGroupCount>;
         using SpatialType = TS<World>;
         using SpatialInfoType = typename SpatialType::SpatialInfoType;
         using ResolverType = TR<World>;
@@ -31,21 +41,79 @@ namespace ssvsc
         using SensorType = Sensor<World>;
         using DetectionInfoType = DetectionInfo<World>;
         using ResolutionInfoType = ResolutionInfo<World>;
+        using StateType = WorldState<World>;
         friend BaseType;
         friend BodyType;
         friend SensorType;
 
     private:
+        Impl::BodyStorage storage;
         ssvu::MonoManager<BodyType> bodies;
+        // Bodies created since the last `step`: `bodies` only yields them
+        // once refreshed.
+        std::vector<BodyType*> created;
         ssvu::MonoManager<SensorType> sensors;
 
         SpatialType spatial;
         ResolverType resolver;
+        WorldStats stats;
+
+        // Dynamic layer: the bodies updated every frame. Statics are only
+        // refreshed when one of them is added, removed, moved or resized.
+        std::vector<BodyType*> dynamics;
+        bool layersInvalid{true};
+
+        SleepSettings sleep;
+        Impl::IslandSet islands;
+        // Sleeping bodies touching these areas wake up. Areas added during
+        // a frame are checked during the next one.
+        std::vector<AABB> wakeAreas, nextWakeAreas;
+
+        TimestepSettings timestep;
+        FT accumulator{0};
+        // Bodies save their position when updated by the last substep of
+        // `advance`, stamped with `positionsStep`.
+        SizeT positionsStep{0};
+        bool savingPositions{false};
+
+        // Bodies faster than this on either axis are swept, see
+        // `Body::setContinuous`.
+        float continuousSpeed{ssvu::NumLimits<float>::max()};
+
+        Impl::ScratchPool<BodyType*> queryScratch;
+        // Candidate stacks of `runQueries`, one per thread.
+        std::vector<std::vector<BodyType*>> batchBuffers;
+        Impl::ContactCache<World> contactCache;
+        bool contactEvents{false};
+        Impl::EventBuffer<World> events;
+        EventMode eventMode{EventMode::Inline};
+
+        // Bodies detecting collisions in the current update.
+        std::vector<BodyType*> active;
+
+        // Two-phase update state, only used when `pool` is set.
+        UPtr<ThreadPool> pool;
+        std::vector<Impl::ContactRange> ranges;
+        std::vector<Impl::DetectionBuffer<World>> buffers;
 
         inline void delBody(BodyType* mBase) noexcept
         {
             SSVU_ASSERT(mBase != nullptr);
             bodies.del(*mBase);
+            invalidateLayers();
+        }
+        inline void invalidateLayers() noexcept { layersInvalid = true; }
+        inline void refreshLayers()
+        {
+            if(!layersInvalid) return;
+            layersInvalid = false;
+
+            dynamics.clear();
+            for(const auto& b : bodies)
+                if(b->isStatic())
+                    b->refreshStatic();
+                else
+                    dynamics.emplace_back(&*b);
         }
         inline void delSensor(SensorType* mBase) noexcept
         {
@@ -53,6 +121,197 @@ namespace ssvsc
             sensors.del(*mBase);
         }
 
+        inline void addWakeArea(const AABB& mArea)
+        {
+            if(sleep.enabled) nextWakeAreas.emplace_back(mArea);
+        }
+
+        // Returns `true` if `mBody` sleeps through this frame.
+        inline bool isSleeping(BodyType& mBody)
+        {
+            if(!mBody.isAsleep()) return false;
+
+            for(const auto& a : wakeAreas)
+                if(a.isTouching(mBody.getShape()))
+                {
+                    mBody.wake();
+                    return false;
+                }
+
+            return true;
+        }
+
+        // Puts to sleep the islands, bodies resolving against each other,
+        // whose members have all been resting for long enough.
+        inline void sleepIslands()
+        {
+            const SizeT count{dynamics.size()};
+            islands.reset(count);
+            for(SizeT i{0}; i < count; ++i) dynamics[i]->islandIdx = i;
+
+            // `toResolve` was filled this frame, or cleared.
+            for(SizeT i{0}; i < count; ++i)
+                for(const auto& o : dynamics[i]->toResolve)
+                    if(o->islandIdx < count && dynamics[o->islandIdx] == o &&
+                        !o->isAsleep() && !o->isStatic())
+                        islands.unite(i, o->islandIdx);
+
+            for(SizeT i{0}; i < count; ++i)
+            {
+                const auto& b(*dynamics[i]);
+                if(b.isAsleep() || b.isStatic() ||
+                    b.restingFrames < sleep.frames)
+                    islands.setNotReady(i);
+            }
+
+            for(SizeT i{0}; i < count; ++i)
+            {
+                if(!islands.isReady(i)) continue;
+
+                const auto last(islands.append(i));
+                if(last != Impl::IslandSet::none)
+                    dynamics[last]->islandNext = dynamics[i];
+            }
+
+            for(SizeT i{0}; i < count; ++i)
+            {
+                if(islands.find(i) != i ||
+                    islands.getLast(i) == Impl::IslandSet::none)
+                    continue;
+
+                // Close the ring and put its members to sleep.
+                auto* first(dynamics[islands.getFirst(i)]);
+                dynamics[islands.getLast(i)]->islandNext = first;
+
+                auto* b(first);
+                do
+                {
+                    auto* next(b->islandNext);
+                    b->sleep(next);
+                    b = next;
+                } while(b != first);
+            }
+
+            for(const auto& b : dynamics)
+                if(b->isAsleep()) ++stats.sleepingBodies;
+        }
+
+        inline auto getContactEnder(FT mFT) const noexcept
+        {
+            return [mFT](BodyType& mA, BodyType& mB)
+            {
+                mA.onContactEnd({mB, mB.getUserData(), mFT});
+                mB.onContactEnd({mA, mA.getUserData(), mFT});
+            };
+        }
+
+        // Runs the callbacks of the awake dynamic bodies first: the ones
+        // still moving this frame are flagged as detecting.
+        inline void prepareBodies()
+        {
+            active.clear();
+            for(const auto& b : dynamics)
+            {
+                if(isSleeping(*b) || !b->prepare()) continue;
+
+                b->chunk->flags[b->idx] |= Impl::BodyFlags::detecting;
+                active.emplace_back(b);
+            }
+        }
+
+        // Moves every active body before any of them detects collisions.
+        // Cells are shared between bodies: sweep and rebuild them
+        // serially.
+        inline void moveBodies(FT mFT)
+        {
+            for(const auto& b : active) storage.markIntegrate(b->slot);
+            storage.integrate(mFT);
+
+            for(const auto& b : active)
+            {
+                if(b->mustSweep()) b->sweep();
+                b->spatialInfo.template preUpdate<BodyTag>();
+            }
+        }
+
+        inline void updateBodiesSerial(FT mFT)
+        {
+            moveBodies(mFT);
+            for(const auto& b : active) b->update(mFT);
+            for(const auto& b : active)
+                b->chunk->flags[b->idx] &= ~Impl::BodyFlags::detecting;
+        }
+
+        inline void updateBodiesTwoPhase(FT mFT)
+        {
+            moveBodies(mFT);
+
+            for(auto& b : buffers) b.clear();
+            ranges.resize(active.size());
+
+            pool->forEach(active.size(), [this](SizeT mI, SizeT mThread)
+                {
+                    auto& buffer(buffers[mThread]);
+                    auto& range(ranges[mI]);
+
+                    range.thread = mThread;
+                    range.begin = buffer.contacts.size();
+                    active[mI]->detect(buffer, mThread);
+                    range.end = buffer.contacts.size();
+                });
+
+            // Callbacks, then resolution, run in body order regardless of
+            // which thread detected what.
+            for(SizeT i{0}; i < active.size(); ++i)
+            {
+                const auto& range(ranges[i]);
+                const auto* contacts(buffers[range.thread].contacts.data());
+                active[i]->dispatchContacts(
+                    mFT, contacts + range.begin, contacts + range.end);
+            }
+            for(const auto& b : active)
+            {
+                b->chunk->flags[b->idx] &= ~Impl::BodyFlags::detecting;
+                b->resolve();
+            }
+
+            for(const auto& b : buffers)
+            {
+                stats.pairTests += b.pairTests;
+                stats.contacts += b.contacts.size();
+            }
+        }
+
+        // One frame of `update`. Destroyed bodies are freed by `refresh`:
+        // end their contacts and drop their events first.
+        inline void step(FT mFT)
+        {
+            stats.reset();
+
+            if(contactEvents) contactCache.purge(getContactEnder(mFT));
+            events.purge();
+            bodies.refresh();
+            created.clear();
+            sensors.refresh();
+            spatial.refresh();
+            refreshLayers();
+
+            wakeAreas.clear();
+            std::swap(wakeAreas, nextWakeAreas);
+
+            prepareBodies();
+            if(pool != nullptr)
+                updateBodiesTwoPhase(mFT);
+            else
+                updateBodiesSerial(mFT);
+
+            if(sleep.enabled) sleepIslands();
+            if(contactEvents) contactCache.endFrame(getContactEnder(mFT));
+
+            for(const auto& s : sensors) s->update(mFT);
+            resolver.postUpdate(*this);
+        }
+
     public:
         template <typename... TArgs>
         inline World(TArgs&&... mArgs)
@@ -63,40 +322,319 @@ namespace ssvsc
 
         inline auto& create(const Vec2i& mPos, const Vec2i& mSize, bool mStatic)
         {
-            return bodies.create(*this, mStatic, mPos, mSize);
+            invalidateLayers();
+            auto& result(bodies.create(*this, mStatic, mPos, mSize));
+            created.emplace_back(&result);
+            return result;
         }
         inline auto& createSensor(const Vec2i& mPos, const Vec2i& mSize)
         {
             return sensors.create(*this, mPos, mSize);
         }
 
+        // Only the dynamic bodies are updated: statics do not call
+        // `onPreUpdate` and cost nothing until one of them changes.
+        // Deferred events of the previous update are dropped.
         inline void update(FT mFT)
         {
-            bodies.refresh();
-            sensors.refresh();
-            for(const auto& b : bodies) b->update(mFT);
-            for(const auto& s : sensors) s->update(mFT);
-            resolver.postUpdate(*this);
+            events.clear();
+            step(mFT);
         }
+
+        // Adds `mDt` of real time and runs as many fixed steps of
+        // `update` as it covers, see `TimestepSettings`. Positions before
+        // the last step are kept for `Body::getInterpolatedPosition`, and
+        // deferred events of every step are kept until the next call.
+        inline AdvanceResult advance(FT mDt)
+        {
+            SSVU_ASSERT(timestep.step > 0);
+            AdvanceResult result;
+            events.clear();
+
+            accumulator += mDt;
+            auto steps(SizeT(accumulator / timestep.step));
+            if(steps > timestep.maxSubsteps)
+            {
+                result.droppedSteps = steps - timestep.maxSubsteps;
+                accumulator -= result.droppedSteps * timestep.step;
+                steps = timestep.maxSubsteps;
+            }
+
+            for(; result.substeps < steps; ++result.substeps)
+            {
+                savingPositions = result.substeps + 1 == steps;
+                if(savingPositions) ++positionsStep;
+                step(timestep.step);
+                accumulator -= timestep.step;
+            }
+            savingPositions = false;
+
+            // Rounding must not leave a negative remainder.
+            accumulator = std::max(accumulator, FT(0));
+            result.alpha = accumulator / timestep.step;
+            return result;
+        }
+
+        // Changing the step keeps the accumulated time.
+        inline void setTimestepSettings(const TimestepSettings& mSettings)
+        {
+            timestep = mSettings;
+        }
+        inline const auto& getTimestepSettings() const noexcept
+        {
+            return timestep;
+        }
+
+        // Number of threads used by `update`, including the calling one.
+        // With `0` (the default) every body integrates, detects and
+        // resolves in turn. With `1` or more, all bodies are integrated
+        // first in a single pass over `BodyStorage`, detection is split
+        // across the threads and finds every overlapping pair once, then
+        // contacts are dispatched and bodies resolved in body order. The
+        // result of the two-phase update does not depend on the number of
+        // threads.
+        inline void setThreadCount(SizeT mCount)
+        {
+            pool.reset();
+            buffers.clear();
+            spatial.setThreadCount(mCount);
+            if(mCount == 0) return;
+
+            pool = std::make_unique<ThreadPool>(mCount);
+            buffers.resize(mCount);
+        }
+        inline SizeT getThreadCount() const noexcept
+        {
+            return pool == nullptr ? 0 : pool->getThreadCount();
+        }
+
+        // Disabling sleeping wakes every body.
+        inline void setSleepSettings(const SleepSettings& mSettings)
+        {
+            sleep = mSettings;
+            if(sleep.enabled) return;
+
+            for(const auto& b : bodies) b->wake();
+            nextWakeAreas.clear();
+        }
+        inline const auto& getSleepSettings() const noexcept { return sleep; }
+
+        // Dynamic bodies whose velocity exceeds `mSpeed` on either axis
+        // are swept like continuous bodies: their movement stops at the
+        // first body they would resolve against instead of passing through
+        // it. Never by default.
+        inline void setContinuousSpeed(float mSpeed) noexcept
+        {
+            continuousSpeed = mSpeed;
+        }
+        inline float getContinuousSpeed() const noexcept
+        {
+            return continuousSpeed;
+        }
+
+        // When enabled, overlapping pairs are kept across frames and bodies
+        // get `onContactBegin` when a pair starts overlapping,
+        // `onContactStay` every following frame and `onContactEnd` once it
+        // stops, or one of them is destroyed. Pairs of sleeping or static
+        // bodies stay without events. Disabling drops the pairs silently.
+        inline void setContactEvents(bool mEnabled)
+        {
+            contactEvents = mEnabled;
+            if(!contactEvents) contactCache.clear();
+        }
+        inline bool getContactEvents() const noexcept { return contactEvents; }
+
+        // With `EventMode::Deferred`, bodies do not call `onDetection` and
+        // `onResolution` during the update: the events are recorded
+        // instead, in order, and can be read or drained once it returns.
+        // Resolutions cannot be vetoed. Sensors always call their
+        // callbacks. Changing the mode drops the recorded events.
+        inline void setEventMode(EventMode mMode) noexcept
+        {
+            eventMode = mMode;
+            events.clear();
+        }
+        inline EventMode getEventMode() const noexcept { return eventMode; }
+
+        inline const auto& getDetectionEvents() const noexcept
+        {
+            return events.detections;
+        }
+        inline const auto& getResolutionEvents() const noexcept
+        {
+            return events.resolutions;
+        }
+
+        // Calls `mOnDetection` with every `DetectionEvent` and
+        // `mOnResolution` with every `ResolutionEvent`, then drops them.
+        // The callbacks may destroy bodies, but must not update the world.
+        template <typename TFD, typename TFR>
+        inline void drainEvents(
+            const TFD& mOnDetection, const TFR& mOnResolution)
+        {
+            for(const auto& e : events.detections) mOnDetection(e);
+            for(const auto& e : events.resolutions) mOnResolution(e);
+            events.clear();
+        }
+
+        // Copies the state of the simulation to `mState`: every living
+        // body's shapes, velocities, flags, groups, resolver state and
+        // sleeping state, their place in the spatial backend, the contact
+        // pairs and the fixed timestep accumulator. Sensors and callbacks
+        // are not saved.
+        inline void saveState(StateType& mState) const
+        {
+            storage.save(mState.chunks);
+            mState.bodyChanges = storage.getChanges();
+
+            mState.bodies.clear();
+            const auto& saveBody([&mState](BodyType& mB)
+                {
+                    if(!mB.isAlive()) return;
+                    mState.bodies.push_back({&mB, mB.data, mB, mB,
+                        mB.spatialInfo.getState(), mB.restingFrames,
+                        mB.islandNext, mB.outOfBounds, mB.mustInit});
+                });
+            for(const auto& b : bodies) saveBody(*b);
+            for(const auto& b : created) saveBody(*b);
+
+            mState.contactCache = contactCache;
+            mState.wakeAreas = nextWakeAreas;
+            mState.accumulator = accumulator;
+            mState.positionsStep = positionsStep;
+        }
+
+        // Restores a state saved by `saveState` of this world. The world
+        // must hold the same living bodies as then: if any was created or
+        // destroyed since, nothing is restored and `false` is returned.
+        // The spatial backend gets back the membership it had, not one
+        // recomputed from the shapes: only the bodies whose membership
+        // changed since are touched. Deferred events are kept.
+        inline bool loadState(const StateType& mState)
+        {
+            if(mState.bodyChanges != storage.getChanges()) return false;
+
+            bool layersChanged{false};
+            for(const auto& s : mState.bodies)
+            {
+                const auto& b(*s.body);
+                const auto& c(mState.getChunk(b.slot));
+                layersChanged |= bool((b.chunk->flags[b.idx] ^ c.flags[b.idx]) &
+                                      Impl::BodyFlags::isStatic);
+            }
+
+            storage.load(mState.chunks);
+
+            for(const auto& s : mState.bodies)
+            {
+                auto& b(*s.body);
+                b.data = s.data;
+                b.copyGroups(s.groups);
+                static_cast<ResolverInfoType&>(b) = s.resolverInfo;
+                b.restingFrames = s.restingFrames;
+                b.islandNext = s.islandNext;
+                b.outOfBounds = s.outOfBounds;
+                b.mustInit = s.mustInit;
+                b.spatialInfo.template setState<BodyTag>(s.spatial);
+            }
+            if(layersChanged) invalidateLayers();
+
+            contactCache = mState.contactCache;
+            nextWakeAreas = mState.wakeAreas;
+            accumulator = mState.accumulator;
+            positionsStep = mState.positionsStep;
+            return true;
+        }
+
         inline void clear() noexcept
         {
+            contactCache.clear();
+            events.clear();
             bodies.clear();
+            created.clear();
             sensors.clear();
+            dynamics.clear();
+            invalidateLayers();
+            nextWakeAreas.clear();
         }
 
         inline const auto& getBodies() const noexcept { return bodies; }
+        // Non-static bodies, as of the last `update`.
+        inline const auto& getDynamicBodies() const noexcept
+        {
+            return dynamics;
+        }
         inline const auto& getSensors() const noexcept { return sensors; }
         inline const auto& getSpatial() const noexcept { return spatial; }
         inline const auto& getResolver() const noexcept { return resolver; }
+        inline const auto& getStats() const noexcept { return stats; }
 
         template <QueryType TType, QueryMode TMode = QueryMode::All,
             typename... TArgs>
-        inline auto getQuery(TArgs&&... mArgs) noexcept
+        inline auto getQuery(TArgs&&... mArgs)
         {
             return Query<World,
                 typename QueryTypeDispatcher<World, SpatialType, TType>::Type,
                 typename QueryModeDispatcher<World, SpatialType, TMode>::Type>{
-                spatial, FWD(mArgs)...};
+                queryScratch, spatial, FWD(mArgs)...};
+        }
+
+        // Number of bodies overlapping `mArea`, counted without gathering
+        // them. `mArgs` are the arguments `Query::next` takes in `TMode`.
+        template <QueryMode TMode = QueryMode::All, typename... TArgs>
+        inline SizeT getAreaCount(
+            const AABB& mArea, const TArgs&... mArgs) const
+        {
+            using InternalType = typename QueryTypeDispatcher<World,
+                SpatialType, QueryType::Area>::Type;
+            using ModeType =
+                typename QueryModeDispatcher<World, SpatialType, TMode>::Type;
+
+            return InternalType{spatial, mArea}.template count<ModeType>(
+                mArgs...);
+        }
+
+        // Runs the query of every request (see `PointRequest`,
+        // `DistanceRequest` and `RayRequest`) and writes what it found to
+        // `mHits`, in request order: rays report their first hit, like
+        // `Query::firstHit`, and distances the body with the closest
+        // shape. `mArgs` go to `Query::next`, as for
+        // `QueryMode::ByGroup`. Requests are split across the threads set
+        // by `setThreadCount`: queries only read the world, which must not
+        // change during the call.
+        template <QueryMode TMode = QueryMode::All, typename TRequest,
+            typename... TArgs>
+        inline void runQueries(const std::vector<TRequest>& mRequests,
+            std::vector<QueryHit<World>>& mHits, const TArgs&... mArgs)
+        {
+            using Traits = Impl::RequestTraits<TRequest>;
+            using InternalType = typename QueryTypeDispatcher<World,
+                SpatialType, Traits::type>::Type;
+            using ModeType =
+                typename QueryModeDispatcher<World, SpatialType, TMode>::Type;
+
+            mHits.resize(mRequests.size());
+            batchBuffers.resize(std::max(getThreadCount(), SizeT(1)));
+
+            const auto run([&](SizeT mI, SizeT mThread)
+                {
+                    const auto& r(mRequests[mI]);
+                    auto& buffer(batchBuffers[mThread]);
+                    auto internal(
+                        Traits::template make<InternalType>(spatial, r));
+
+                    buffer.clear();
+                    auto& hit(mHits[mI]);
+                    Traits::template find<ModeType>(
+                        hit, buffer, internal, r, mArgs...);
+                    hit.distance =
+                        ssvs::getDistEuclidean(Vec2f(r.pos), hit.pos);
+                });
+
+            if(pool == nullptr)
+                for(SizeT i{0}; i < mRequests.size(); ++i) run(i, 0);
+            else
+                pool->forEach(mRequests.size(), run);
         }
     };
 }
@@ -0,0 +1,63 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_WORLDSTATE
+#define SSVSC_WORLD_WORLDSTATE
+
+namespace ssvsc
+{
+    template <typename TW>
+    class Body;
+
+    namespace Impl
+    {
+        // What a body keeps outside of `BodyStorage`.
+        template <typename TW>
+        struct BodyState
+        {
+            using BodyType = Body<TW>;
+            using GroupableType = GroupableOf<Base<TW>, TW::groupCount>;
+
+            BodyType* body;
+            BodyData data;
+            GroupableType groups;
+            typename TW::ResolverInfoType resolverInfo;
+            typename TW::SpatialInfoType::State spatial;
+            SizeT restingFrames;
+            BodyType* islandNext;
+            bool outOfBounds, mustInit;
+        };
+    }
+
+    // Snapshot of a world, see `World::saveState`. The buffers keep their
+    // capacity, so saving to the same state again does not allocate.
+    template <typename TW>
+    class WorldState
+    {
+        friend TW;
+
+    private:
+        std::vector<Impl::BodyStorage::Chunk> chunks;
+        std::vector<Impl::BodyState<TW>> bodies;
+        Impl::ContactCache<TW> contactCache;
+        std::vector<AABB> wakeAreas;
+        FT accumulator{0};
+        SizeT positionsStep{0};
+        // `BodyStorage::getChanges` when saved.
+        SizeT bodyChanges{0};
+
+        // Saved chunk of `mSlot`.
+        inline const auto& getChunk(SizeT mSlot) const noexcept
+        {
+            SSVU_ASSERT(mSlot / Impl::BodyStorage::chunkSize < chunks.size());
+            return chunks[mSlot / Impl::BodyStorage::chunkSize];
+        }
+
+    public:
+        inline bool isEmpty() const noexcept { return chunks.empty(); }
+        inline SizeT getBodyCount() const noexcept { return bodies.size(); }
+    };
+}
+
+#endif
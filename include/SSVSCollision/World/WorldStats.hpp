@@ -0,0 +1,26 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+#ifndef SSVSC_WORLD_WORLDSTATS
+#define SSVSC_WORLD_WORLDSTATS
+
+namespace ssvsc
+{
+    // Per-frame counters, reset at the beginning of every `World::update`.
+    struct WorldStats
+    {
+        // Number of narrowphase (AABB vs AABB) tests performed. The
+        // serial update tests a pair again when the body with the higher
+        // slot resolves against the other one.
+        SizeT pairTests{0};
+        // Number of overlapping pairs, each counted once in both updates.
+        SizeT contacts{0};
+        // Number of sleeping bodies at the end of the frame.
+        SizeT sleepingBodies{0};
+
+        inline void reset() noexcept { *this = WorldStats{}; }
+    };
+}
+
+#endif
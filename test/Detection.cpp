@@ -0,0 +1,222 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Checks that the serial and the two-phase updates report the same
+// detections, on every spatial backend. Exits with a non-zero status if a
+// check fails.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <SSVSCollision/SSVSCollision.hpp>
+
+namespace test
+{
+    using namespace ssvsc;
+
+    int failures{0};
+
+    inline void check(bool mOk, const std::string& mWhat)
+    {
+        if(mOk) return;
+        std::printf("FAILED: %s\n", mWhat.c_str());
+        ++failures;
+    }
+
+    struct Counts
+    {
+        int first{0}, second{0};
+    };
+
+    template <typename TW>
+    inline auto& makeBody(TW& mWorld, const Vec2i& mPos, Counts& mCounts,
+        int Counts::*mCount)
+    {
+        auto& result(mWorld.create(mPos, {1600, 1600}, false));
+        result.onDetection += [&mCounts, mCount](const auto&)
+        {
+            ++(mCounts.*mCount);
+        };
+        return result;
+    }
+
+    // Only one body of the pair checks the other: the pair is still
+    // reported once, to both, whichever body has the lower slot.
+    template <typename TW, typename... TArgs>
+    inline void oneSidedCheck(
+        const char* mName, SizeT mThreads, bool mFirstChecks, TArgs... mArgs)
+    {
+        TW w{mArgs...};
+        w.setThreadCount(mThreads);
+
+        Counts counts;
+        auto& a(makeBody(w, {0, 0}, counts, &Counts::first));
+        auto& b(makeBody(w, {800, 0}, counts, &Counts::second));
+        a.addGroups(1);
+        b.addGroups(2);
+        if(mFirstChecks)
+            a.addGroupsToCheck(2);
+        else
+            b.addGroupsToCheck(1);
+
+        w.update(1.f);
+
+        const auto what(std::string{mName} + " one-sided check, threads " +
+                        std::to_string(mThreads) +
+                        (mFirstChecks ? ", first" : ", second") + " checks");
+        check(counts.first == 1 && counts.second == 1, what);
+    }
+
+    // A non-resolving bullet with the higher slot moves into a resting
+    // body: the overlap is reported in the frame it appears.
+    template <typename TW, typename... TArgs>
+    inline void bulletOverlap(const char* mName, SizeT mThreads, TArgs... mArgs)
+    {
+        TW w{mArgs...};
+        w.setThreadCount(mThreads);
+
+        Counts counts;
+        auto& target(makeBody(w, {0, 0}, counts, &Counts::first));
+        auto& bullet(makeBody(w, {-5000, 0}, counts, &Counts::second));
+        target.addGroups(1);
+        bullet.addGroups(2);
+        bullet.addGroupsToCheck(1);
+        bullet.setResolve(false);
+        bullet.setVelocity({3000.f, 0.f});
+
+        int frame{0};
+        for(int i{1}; i <= 3 && frame == 0; ++i)
+        {
+            w.update(1.f);
+            if(counts.second != 0) frame = i;
+        }
+
+        const auto what(std::string{mName} + " bullet overlap, threads " +
+                        std::to_string(mThreads));
+        check(frame == 2 && counts.first == 1 && counts.second == 1, what);
+    }
+
+    // A continuous bullet that does not resolve is stopped at a thin wall
+    // it checks, so that the hit is reported, then goes through it.
+    template <typename TW, typename... TArgs>
+    inline void continuousBullet(
+        const char* mName, SizeT mThreads, TArgs... mArgs)
+    {
+        TW w{mArgs...};
+        w.setThreadCount(mThreads);
+
+        auto& wall(w.create({8000, 0}, {200, 8000}, true));
+        wall.addGroups(1);
+
+        Counts counts;
+        auto& bullet(makeBody(w, {-2000, 0}, counts, &Counts::second));
+        bullet.addGroups(2);
+        bullet.addGroupsToCheck(1);
+        bullet.setResolve(false);
+        bullet.setContinuous(true);
+        bullet.setVelocity({15000.f, 0.f});
+
+        const auto what(std::string{mName} + " continuous bullet, threads " +
+                        std::to_string(mThreads));
+
+        w.update(1.f);
+        check(counts.second == 1 && bullet.getPosition().x < 8000, what);
+        w.update(1.f);
+        check(bullet.getPosition().x > 8000, what + " goes through");
+    }
+
+    // With more groups than a word holds, bodies that move and change
+    // groups between frames are told about every overlapping body that
+    // a dynamic side checks, once. Most bodies are static, so that most
+    // cells are only visited for their groups, and nothing is resolved.
+    template <typename TW, typename... TArgs>
+    inline void wideGroups(const char* mName, SizeT mThreads, TArgs... mArgs)
+    {
+        TW w{mArgs...};
+        w.setThreadCount(mThreads);
+
+        const Group groups[]{0, 70, 127};
+        std::mt19937 rnd{7};
+        std::uniform_int_distribution<int> pos{-8000, 33000}, group{0, 2};
+
+        std::vector<typename TW::BodyType*> bodies;
+        std::vector<int> counts(300);
+        for(auto& c : counts)
+        {
+            const bool isStatic(bodies.size() % 4 != 0);
+            auto& b(w.create({pos(rnd), pos(rnd)}, {2400, 2400}, isStatic));
+            b.addGroupsNoResolve(groups[0], groups[1], groups[2]);
+            b.onDetection += [&c](const auto&)
+            {
+                ++c;
+            };
+            bodies.emplace_back(&b);
+        }
+
+        SizeT bad{0};
+        for(int iFrame{0}; iFrame < 10; ++iFrame)
+        {
+            for(auto& b : bodies)
+            {
+                b->clearGroups();
+                b->clearGroupsToCheck();
+                b->addGroups(groups[group(rnd)]);
+                b->addGroupsToCheck(groups[group(rnd)]);
+                if(iFrame > 0 && !b->isStatic() && group(rnd) == 0)
+                    b->setPosition({pos(rnd), pos(rnd)});
+            }
+
+            std::fill(counts.begin(), counts.end(), 0);
+            w.update(1.f);
+
+            for(SizeT i{0}; i < bodies.size(); ++i)
+            {
+                const auto& b(*bodies[i]);
+                int expected{0};
+                for(const auto& o : bodies)
+                    if(o != &b &&
+                        ((!b.isStatic() && b.mustCheck(*o)) ||
+                            (!o->isStatic() && o->mustCheck(b))) &&
+                        b.getShape().isOverlapping(o->getShape()))
+                        ++expected;
+
+                if(counts[i] != expected) ++bad;
+            }
+        }
+
+        check(bad == 0, std::string{mName} + " wide groups, threads " +
+                            std::to_string(mThreads));
+    }
+
+    template <template <typename> class TS, typename... TArgs>
+    inline void run(const char* mName, TArgs... mArgs)
+    {
+        using TW = World<TS, Impulse>;
+
+        for(SizeT threads : {0, 2})
+        {
+            for(bool firstChecks : {false, true})
+                oneSidedCheck<TW>(mName, threads, firstChecks, mArgs...);
+            bulletOverlap<TW>(mName, threads, mArgs...);
+            continuousBullet<TW>(mName, threads, mArgs...);
+            wideGroups<World<TS, Impulse, 128>>(mName, threads, mArgs...);
+        }
+    }
+}
+
+int main()
+{
+    using namespace ssvsc;
+
+    test::run<Grid>("Grid", 16, 16, 3200, 4);
+    test::run<HashGrid>("HashGrid", 16, 16, 3200, 4);
+    test::run<ChunkedGrid>("ChunkedGrid", 3200);
+    test::run<MultiGrid>("MultiGrid", 16, 16, 3200, 4);
+    test::run<SweepAndPrune>("SweepAndPrune");
+    test::run<DynamicTree>("DynamicTree");
+
+    if(test::failures == 0) std::printf("All checks passed.\n");
+    return test::failures == 0 ? 0 : 1;
+}
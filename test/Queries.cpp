@@ -0,0 +1,326 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Checks the queries of every spatial backend. Exits with a non-zero
+// status if a check fails.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <SSVSCollision/SSVSCollision.hpp>
+
+namespace test
+{
+    using namespace ssvsc;
+
+    // The worlds span 16x16 cells of 3200, from -12800 on.
+    constexpr int cellSize{3200}, worldMin{-12800}, worldSize{51200};
+
+    int failures{0};
+
+    inline void check(bool mOk, const std::string& mWhat)
+    {
+        if(mOk) return;
+        std::printf("FAILED: %s\n", mWhat.c_str());
+        ++failures;
+    }
+
+    inline AABB getWorldArea()
+    {
+        const int half{worldSize / 2};
+        return AABB{Vec2i{worldMin + half, worldMin + half}, Vec2i{half, half}};
+    }
+
+    // Random positions well inside the world, and sizes up to a few cells.
+    struct Random
+    {
+        std::mt19937 rnd{7};
+        std::uniform_int_distribution<int> pos{worldMin + 5000, 33000},
+            size{200, 9000};
+
+        inline Vec2i getPos() { return {pos(rnd), pos(rnd)}; }
+        inline Vec2i getSize() { return {size(rnd), size(rnd)}; }
+    };
+
+    // A third of the bodies are static. Bodies are in group 0 or 1.
+    template <typename TW>
+    inline auto fill(TW& mWorld, Random& mRandom, int mCount)
+    {
+        std::vector<typename TW::BodyType*> result;
+        for(int i{0}; i < mCount; ++i)
+        {
+            auto& b(mWorld.create(
+                mRandom.getPos(), mRandom.getSize(), i % 3 == 0));
+            b.addGroups(i % 2);
+            result.emplace_back(&b);
+        }
+
+        mWorld.update(1.f);
+        return result;
+    }
+
+    // Every ring of the shared table holds each cell at its Chebyshev
+    // distance once, past the precomputed rings too.
+    inline void ringTable()
+    {
+        const auto& rings(Impl::getRingTable());
+        SizeT bad{0};
+
+        for(int r{0}; r <= 2 * Impl::RingTable::radius; ++r)
+        {
+            std::set<std::pair<int, int>> cells;
+            for(SizeT i{0}; i < Impl::RingTable::getRingSize(r); ++i)
+            {
+                const auto o(rings(r, i));
+                if(std::max(std::abs(o.x), std::abs(o.y)) != r) ++bad;
+                cells.emplace(o.x, o.y);
+            }
+
+            const SizeT side(2 * r + 1), inner(std::max(0, 2 * r - 1));
+            if(cells.size() != side * side - inner * inner) ++bad;
+        }
+
+        check(bad == 0, "ring table holds every cell once");
+    }
+
+    // Distance queries yield the bodies whose corner facing the start is
+    // within the distance.
+    template <typename TW>
+    inline void distanceBruteForce(const std::string& mName, TW& mWorld,
+        const std::vector<typename TW::BodyType*>& mBodies, Random& mRandom)
+    {
+        std::uniform_int_distribution<int> distance{0, 20000};
+        SizeT bad{0};
+
+        for(int i{0}; i < 200; ++i)
+        {
+            const auto o(mRandom.getPos());
+            const int d{distance(mRandom.rnd)};
+            const bool byGroup(i % 2);
+
+            std::set<const void*> got;
+            auto q(mWorld.template getQuery<QueryType::Distance,
+                QueryMode::ByGroup>(o, d));
+            auto qAll(mWorld.template getQuery<QueryType::Distance>(o, d));
+            while(auto* b = byGroup ? q.next(1) : qAll.next()) got.insert(b);
+
+            std::set<const void*> expected;
+            for(const auto& b : mBodies)
+            {
+                if(byGroup && !b->hasGroup(1)) continue;
+
+                const auto& s(b->getShape());
+                const Vec2i corner{o.x < s.getX() ? s.getLeft() : s.getRight(),
+                    o.y < s.getY() ? s.getTop() : s.getBottom()};
+                if(ssvs::getDistSquaredEuclidean(Vec2f(corner), Vec2f(o)) <=
+                    float(d) * float(d))
+                    expected.insert(b);
+            }
+
+            if(got != expected) ++bad;
+        }
+
+        check(bad == 0, mName + " distance queries match brute force");
+    }
+
+    // Nearest queries yield the `k` closest shapes, closest first.
+    template <typename TW>
+    inline void nearestBruteForce(const std::string& mName, TW& mWorld,
+        const std::vector<typename TW::BodyType*>& mBodies, Random& mRandom)
+    {
+        std::uniform_int_distribution<SizeT> count{0, 40};
+        SizeT bad{0};
+
+        for(int i{0}; i < 200; ++i)
+        {
+            const auto o(mRandom.getPos());
+            const auto k(count(mRandom.rnd));
+            const bool byGroup(i % 2);
+
+            std::vector<float> got, expected;
+            auto q(mWorld.template getQuery<QueryType::Nearest,
+                QueryMode::ByGroup>(o, k));
+            auto qAll(mWorld.template getQuery<QueryType::Nearest>(o, k));
+            while(auto* b = byGroup ? q.next(1) : qAll.next())
+                got.push_back(Utils::getDistSquared(b->getShape(), Vec2f(o)));
+
+            for(const auto& b : mBodies)
+                if(!byGroup || b->hasGroup(1))
+                    expected.push_back(
+                        Utils::getDistSquared(b->getShape(), Vec2f(o)));
+            std::sort(expected.begin(), expected.end());
+            if(expected.size() > k) expected.resize(k);
+
+            if(got != expected) ++bad;
+        }
+
+        check(bad == 0, mName + " nearest queries match brute force");
+    }
+
+    // `firstHit` finds the smallest entry of the ray into a shape.
+    template <typename TW>
+    inline void firstHitBruteForce(const std::string& mName, TW& mWorld,
+        const std::vector<typename TW::BodyType*>& mBodies, Random& mRandom)
+    {
+        std::uniform_real_distribution<float> component{-1.f, 1.f};
+        SizeT bad{0};
+
+        for(int i{0}; i < 200; ++i)
+        {
+            const auto o(mRandom.getPos());
+            Vec2f dir{component(mRandom.rnd), component(mRandom.rnd)};
+            if(i % 10 == 0) dir.x = 0.f;
+            if(i % 10 == 1) dir.y = 0.f;
+            const bool byGroup(i % 2);
+
+            auto q(mWorld.template getQuery<QueryType::RayCast,
+                QueryMode::ByGroup>(o, dir));
+            auto qAll(mWorld.template getQuery<QueryType::RayCast>(o, dir));
+            const auto* got(byGroup ? q.firstHit(1) : qAll.firstHit());
+
+            float best{ssvu::NumLimits<float>::max()}, t;
+            for(const auto& b : mBodies)
+                if((!byGroup || b->hasGroup(1)) &&
+                    Utils::isRayEntering(
+                        b->getShape(), Vec2f(o), dir, best, t) &&
+                    t < best)
+                    best = t;
+
+            if(got == nullptr)
+            {
+                if(best != ssvu::NumLimits<float>::max()) ++bad;
+                continue;
+            }
+
+            Utils::isRayEntering(got->getShape(), Vec2f(o), dir,
+                ssvu::NumLimits<float>::max(), t);
+            if(std::abs(t - best) > 1e-3f * std::max(1.f, best)) ++bad;
+        }
+
+        check(bad == 0, mName + " ray first hits match brute force");
+    }
+
+    // With more groups than a word holds, bodies changing groups between
+    // frames leave stale groups in the masks of their cells: `ByGroup`
+    // area queries and counts must still match brute force.
+    template <typename TW>
+    inline void groupsBruteForce(const std::string& mName, TW& mWorld,
+        const std::vector<typename TW::BodyType*>& mBodies, Random& mRandom)
+    {
+        const Group groups[]{0, 70, 127};
+        std::uniform_int_distribution<SizeT> pick{0, mBodies.size() - 1};
+        std::uniform_int_distribution<int> group{0, 2}, extent{0, 20000};
+        SizeT bad{0};
+
+        for(int iFrame{0}; iFrame < 10; ++iFrame)
+        {
+            for(int i{0}; i < 100; ++i)
+            {
+                auto& b(*mBodies[pick(mRandom.rnd)]);
+                if(i % 3 == 0) b.clearGroups();
+                b.addGroups(groups[group(mRandom.rnd)]);
+                if(i % 3 == 2 && !b.isStatic())
+                    b.setPosition(mRandom.getPos());
+            }
+            mWorld.update(1.f);
+
+            for(int i{0}; i < 30; ++i)
+            {
+                const AABB area{mRandom.getPos(),
+                    Vec2i{extent(mRandom.rnd), extent(mRandom.rnd)}};
+                const Group g{groups[i % 3]};
+
+                std::set<const void*> got, expected;
+                auto q(mWorld.template getQuery<QueryType::Area,
+                    QueryMode::ByGroup>(area));
+                while(auto* b = q.next(g)) got.insert(b);
+
+                for(const auto& b : mBodies)
+                    if(b->hasGroup(g) && b->getShape().isOverlapping(area))
+                        expected.insert(b);
+
+                if(got != expected ||
+                    mWorld.template getAreaCount<QueryMode::ByGroup>(
+                        area, g) != expected.size())
+                    ++bad;
+            }
+        }
+
+        check(bad == 0, mName + " wide group queries match brute force");
+    }
+
+    // A body moved by `setPosition` is still in its old cells until the
+    // next update: area queries must still report it, once.
+    template <typename TW, typename... TArgs>
+    inline void areaAfterMove(const std::string& mName, TArgs... mArgs)
+    {
+        TW w{mArgs...};
+        auto& b(w.create({5000, 5000}, {1600, 1600}, false));
+        w.update(1.f);
+        b.setPosition({5000 + 3 * cellSize, 5000 + cellSize});
+
+        int found{0};
+        auto q(w.template getQuery<QueryType::Area>(getWorldArea()));
+        while(auto* body = q.next()) found += body == &b;
+
+        check(found == 1, mName + " area query after a move");
+        check(w.getAreaCount(getWorldArea()) == 1,
+            mName + " area count after a move");
+    }
+
+    // The body of a distance request with the closest shape is reported,
+    // even if the centre of another one is closer.
+    template <typename TW, typename... TArgs>
+    inline void batchDistance(const std::string& mName, TArgs... mArgs)
+    {
+        TW w{mArgs...};
+        auto& big(w.create({0, 5000}, {8000, 8000}, true));
+        w.create({3000, 0}, {400, 400}, true);
+        w.update(1.f);
+
+        std::vector<QueryHit<TW>> hits;
+        w.runQueries(std::vector<DistanceRequest>{{{0, 0}, 6000}}, hits);
+
+        check(hits[0].body == &big && hits[0].distance == 1000.f,
+            mName + " batch distance reports the closest shape");
+    }
+
+    template <template <typename> class TS, typename... TArgs>
+    inline void run(const std::string& mName, TArgs... mArgs)
+    {
+        using TW = World<TS, Impulse>;
+
+        areaAfterMove<TW>(mName, mArgs...);
+        batchDistance<TW>(mName, mArgs...);
+
+        Random random;
+        TW w{mArgs...};
+        const auto bodies(fill(w, random, 1000));
+        distanceBruteForce(mName, w, bodies, random);
+        nearestBruteForce(mName, w, bodies, random);
+        firstHitBruteForce(mName, w, bodies, random);
+
+        World<TS, Impulse, 128> wide{mArgs...};
+        groupsBruteForce(mName, wide, fill(wide, random, 1000), random);
+    }
+}
+
+int main()
+{
+    using namespace ssvsc;
+    using namespace test;
+
+    ringTable();
+    run<Grid>("Grid", 16, 16, cellSize, 4);
+    run<HashGrid>("HashGrid", 16, 16, cellSize, 4);
+    run<ChunkedGrid>("ChunkedGrid", cellSize);
+    run<MultiGrid>("MultiGrid", 16, 16, cellSize, 4);
+    run<SweepAndPrune>("SweepAndPrune");
+    run<DynamicTree>("DynamicTree");
+
+    if(failures == 0) std::printf("All checks passed.\n");
+    return failures == 0 ? 0 : 1;
+}
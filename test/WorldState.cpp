@@ -0,0 +1,136 @@
+// Copyright (c) 2013-2015 Vittorio Romeo
+// License: Academic Free License ("AFL") v. 3.0
+// AFL License page: http://opensource.org/licenses/AFL-3.0
+
+// Checks of `World::saveState` and `World::loadState`: a state only loads
+// into a world holding the same living bodies, and loading it restores
+// them. Exits with a non-zero status if a check fails.
+
+#include <cstdio>
+#include <SSVSCollision/SSVSCollision.hpp>
+
+namespace test
+{
+    using namespace ssvsc;
+    using TestWorld = World<Grid, Impulse>;
+
+    int failures{0};
+
+    inline void check(bool mOk, const char* mWhat)
+    {
+        if(mOk) return;
+        std::printf("FAILED: %s\n", mWhat);
+        ++failures;
+    }
+
+    inline auto& makeBody(TestWorld& mWorld, int mX)
+    {
+        auto& result(mWorld.create({mX, 0}, {1600, 1600}, false));
+        result.setVelocity({100.f, 50.f});
+        return result;
+    }
+
+    inline void roundTrip()
+    {
+        TestWorld w{16, 16, 3200, 4};
+        auto& b(makeBody(w, 0));
+        w.update(1.f);
+
+        TestWorld::StateType s;
+        w.saveState(s);
+        const auto pos(b.getPosition());
+        for(int i{0}; i < 5; ++i) w.update(1.f);
+
+        check(w.loadState(s), "round trip loads");
+        check(b.getPosition() == pos, "round trip restores the position");
+    }
+
+    // Bodies created before the save but not updated yet are saved too.
+    inline void pendingBody()
+    {
+        TestWorld w{16, 16, 3200, 4};
+        auto& b(makeBody(w, 0));
+
+        TestWorld::StateType s;
+        w.saveState(s);
+        check(s.getBodyCount() == 1, "pending body is saved");
+        for(int i{0}; i < 5; ++i) w.update(1.f);
+
+        check(w.loadState(s), "pending body loads");
+        check(b.getPosition() == Vec2i(0, 0), "pending body is restored");
+    }
+
+    inline void createThenLoad()
+    {
+        TestWorld w{16, 16, 3200, 4};
+        auto& b(makeBody(w, 0));
+        w.update(1.f);
+
+        TestWorld::StateType s;
+        w.saveState(s);
+
+        // Not updated: the new body is still pending.
+        auto& c(makeBody(w, 6400));
+        w.update(1.f);
+        const auto pos(b.getPosition());
+        check(!w.loadState(s), "create then load fails");
+        check(b.getPosition() == pos, "failed load leaves bodies alone");
+        check(c.getPosition() == Vec2i(6400, 0) + Vec2i(100, 50),
+            "failed load leaves new bodies alone");
+
+        w.saveState(s);
+        makeBody(w, 12800);
+        check(!w.loadState(s), "create without update then load fails");
+    }
+
+    inline void destroyThenLoad()
+    {
+        TestWorld w{16, 16, 3200, 4};
+        makeBody(w, 0);
+        auto& b(makeBody(w, 6400));
+        w.update(1.f);
+
+        TestWorld::StateType s;
+        w.saveState(s);
+        b.destroy();
+        check(!w.loadState(s), "destroy then load fails");
+
+        // The freed slot, and maybe the address, are reused.
+        w.update(1.f);
+        w.saveState(s);
+        auto& c(makeBody(w, 6400));
+        c.destroy();
+        w.update(1.f);
+        makeBody(w, 6400);
+        w.update(1.f);
+        check(!w.loadState(s), "destroy and create then load fails");
+    }
+
+    // Bodies destroyed before the save are not part of it.
+    inline void destroyThenSave()
+    {
+        TestWorld w{16, 16, 3200, 4};
+        auto& b(makeBody(w, 0));
+        makeBody(w, 6400).destroy();
+
+        TestWorld::StateType s;
+        w.saveState(s);
+        check(s.getBodyCount() == 1, "destroyed body is not saved");
+        for(int i{0}; i < 5; ++i) w.update(1.f);
+
+        check(w.loadState(s), "state saved after a destroy loads");
+        check(b.getPosition() == Vec2i(0, 0), "living body is restored");
+    }
+}
+
+int main()
+{
+    test::roundTrip();
+    test::pendingBody();
+    test::createThenLoad();
+    test::destroyThenLoad();
+    test::destroyThenSave();
+
+    if(test::failures == 0) std::printf("All checks passed.\n");
+    return test::failures == 0 ? 0 : 1;
+}